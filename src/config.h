@@ -88,6 +88,8 @@ enum {
   G_TOKEN_YORIGIN = G_TOKEN_LAST + 133,
   G_TOKEN_CHILDREN = G_TOKEN_LAST + 134,
   G_TOKEN_SORT = G_TOKEN_LAST + 135,
+  G_TOKEN_TITLEINTERVAL = G_TOKEN_LAST + 136,
+  G_TOKEN_REFRESHINTERVAL = G_TOKEN_LAST + 137,
   G_TOKEN_TRUE = G_TOKEN_LAST + 138,
   G_TOKEN_FALSE = G_TOKEN_LAST + 139,
   G_TOKEN_MENU = G_TOKEN_LAST + 140,
@@ -116,6 +118,7 @@ enum {
   G_TOKEN_USERSTATE = G_TOKEN_LAST + 163,
   G_TOKEN_USERSTATE2 = G_TOKEN_LAST + 164,
   G_TOKEN_CLIENTSEND = G_TOKEN_LAST + 165,
+  G_TOKEN_MAXITEMS = G_TOKEN_LAST + 166,
   G_TOKEN_ITEM = G_TOKEN_LAST + 170,
   G_TOKEN_SEPARATOR = G_TOKEN_LAST + 171,
   G_TOKEN_SUBMENU = G_TOKEN_LAST + 172,
@@ -112,6 +112,12 @@ GtkWidget *config_parse_data ( gchar *fname, gchar *data, gboolean toplevel )
   g_scanner_scope_add_symbol(scanner,0, "Children", 
       (gpointer)G_TOKEN_CHILDREN );
   g_scanner_scope_add_symbol(scanner,0, "Sort", (gpointer)G_TOKEN_SORT );
+  g_scanner_scope_add_symbol(scanner,0, "Title_interval", 
+      (gpointer)G_TOKEN_TITLEINTERVAL );
+  g_scanner_scope_add_symbol(scanner,0, "Refresh_interval",
+      (gpointer)G_TOKEN_REFRESHINTERVAL );
+  g_scanner_scope_add_symbol(scanner,0, "Max_items",
+      (gpointer)G_TOKEN_MAXITEMS );
   g_scanner_scope_add_symbol(scanner,0, "True", (gpointer)G_TOKEN_TRUE );
   g_scanner_scope_add_symbol(scanner,0, "False", (gpointer)G_TOKEN_FALSE );
   g_scanner_scope_add_symbol(scanner,0, "Menu", (gpointer)G_TOKEN_MENU );
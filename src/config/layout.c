@@ -14,6 +14,7 @@
 #include "../taskbar.h"
 #include "../pager.h"
 #include "../tray.h"
+#include "../wintree.h"
 
 void config_widget ( GScanner *scanner, GtkWidget *widget );
 
@@ -168,6 +169,15 @@ gboolean config_widget_property ( GScanner *scanner, GtkWidget *widget )
         return TRUE;
     }
 
+  if(IS_TRAY(widget))
+    switch ( (gint)scanner->token )
+    {
+      case G_TOKEN_REFRESHINTERVAL:
+        sni_item_set_refresh_interval(
+            config_assign_number(scanner,"refresh_interval"));
+        return TRUE;
+    }
+
   if(IS_TASKBAR(widget))
     switch ( (gint)scanner->token )
     {
@@ -179,6 +189,10 @@ gboolean config_widget_property ( GScanner *scanner, GtkWidget *widget )
         g_object_set_data(G_OBJECT(widget),"title_width",
             GINT_TO_POINTER(config_assign_number(scanner,"title_width")));
         return TRUE;
+      case G_TOKEN_TITLEINTERVAL:
+        wintree_set_title_interval(
+            config_assign_number(scanner,"title_interval"));
+        return TRUE;
       case G_TOKEN_GROUP:
         if(g_scanner_peek_next_token(scanner) == '=')
         {
@@ -246,6 +260,10 @@ gboolean config_widget_property ( GScanner *scanner, GtkWidget *widget )
         flow_grid_set_sort(base_widget_get_child(widget),
               config_assign_boolean(scanner,TRUE,"sort"));
         return TRUE;
+      case G_TOKEN_MAXITEMS:
+        flow_grid_set_max(base_widget_get_child(widget),
+          config_assign_number(scanner, "max_items"));
+        return TRUE;
     }
 
   return FALSE;
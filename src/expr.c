@@ -21,7 +21,8 @@ enum {
   G_TOKEN_ACTIVE  = G_TOKEN_LAST + 7,
   G_TOKEN_PAD     = G_TOKEN_LAST + 8,
   G_TOKEN_IF      = G_TOKEN_LAST + 9,
-  G_TOKEN_CACHED  = G_TOKEN_LAST + 10
+  G_TOKEN_CACHED  = G_TOKEN_LAST + 10,
+  G_TOKEN_MPD     = G_TOKEN_LAST + 11
 };
 
 gdouble expr_parse_num ( GScanner *scanner );
@@ -53,6 +54,7 @@ gboolean expr_is_numeric ( GScanner *scanner )
       (scanner->next_token == '!')||
       (scanner->next_token == (GTokenType)G_TOKEN_DISK)||
       (scanner->next_token == (GTokenType)G_TOKEN_VAL)||
+      (scanner->next_token == (GTokenType)G_TOKEN_MPD)||
       (scanner->next_token == (GTokenType)G_TOKEN_LEFT_PAREN)||
       ((scanner->next_token == G_TOKEN_IDENTIFIER)&&
        (*(scanner->next_value.v_identifier)!='$')));
@@ -442,6 +444,14 @@ gdouble expr_parse_num_value ( GScanner *scanner )
       val = expr_parse_disk ( scanner );
       *((guint *)scanner->user_data) = *((guint *)scanner->user_data) + 1;
       break;
+    case G_TOKEN_MPD:
+      parser_expect_symbol(scanner,'(',"Mpd(String)");
+      str = expr_parse_str(scanner);
+      val = mpd_ipc_get_value(str);
+      g_free(str);
+      parser_expect_symbol(scanner,')',"Mpd(String)");
+      *((guint *)scanner->user_data) = *((guint *)scanner->user_data) + 1;
+      break;
     case G_TOKEN_VAL:
       parser_expect_symbol(scanner,'(',"Val(String)");
       str = expr_parse_str(scanner);
@@ -602,6 +612,7 @@ static GScanner *expr_scanner_new ( void )
   g_scanner_scope_add_symbol(scanner,0, "Pad", (gpointer)G_TOKEN_PAD );
   g_scanner_scope_add_symbol(scanner,0, "If", (gpointer)G_TOKEN_IF );
   g_scanner_scope_add_symbol(scanner,0, "Cached", (gpointer)G_TOKEN_CACHED );
+  g_scanner_scope_add_symbol(scanner,0, "Mpd", (gpointer)G_TOKEN_MPD );
   g_scanner_set_scope(scanner,0);
 
   return scanner;
@@ -10,6 +10,9 @@
 
 G_DEFINE_TYPE_WITH_CODE (FlowGrid, flow_grid, GTK_TYPE_GRID, G_ADD_PRIVATE (FlowGrid));
 
+static GList *flow_grid_dirty;
+static guint flow_grid_idle;
+
 static void flow_grid_get_preferred_width (GtkWidget *widget, gint *minimal, gint *natural)
 {
   FlowGridPrivate *priv;
@@ -48,6 +51,11 @@ static void flow_grid_destroy( GtkWidget *self )
   priv = flow_grid_get_instance_private(FLOW_GRID(self));
 
   g_clear_pointer(&priv->dnd_target,gtk_target_entry_free);
+  flow_grid_dirty = g_list_remove(flow_grid_dirty,self);
+  priv->invalid = FALSE;
+  g_list_free(g_steal_pointer(&priv->pads));
+  g_clear_pointer(&priv->index,g_hash_table_destroy);
+  g_clear_pointer(&priv->children,g_ptr_array_unref);
   GTK_WIDGET_CLASS(flow_grid_parent_class)->destroy(self);
 }
 
@@ -70,6 +78,7 @@ static void flow_grid_init ( FlowGrid *self )
   priv->rows = 1;
   priv->cols = 0;
   priv->limit = TRUE;
+  priv->children = g_ptr_array_new();
   sig = g_strdup_printf("flow-item-%p",self);
   priv->dnd_target = gtk_target_entry_new(sig,0,1);
   g_free(sig);
@@ -123,72 +132,172 @@ void flow_grid_set_rows ( GtkWidget *cgrid, gint rows )
     priv->rows = 1;
 }
 
-void flow_grid_set_sort ( GtkWidget *cgrid, gboolean sort )
+static gboolean flow_grid_scroll_cb ( GtkWidget *widget,
+    GdkEventScroll *event, GtkWidget *cgrid )
 {
   FlowGridPrivate *priv;
+  gint step, button;
 
-  g_return_if_fail(cgrid != NULL);
-  g_return_if_fail(IS_FLOW_GRID(cgrid));
+  g_return_val_if_fail(IS_FLOW_GRID(cgrid),FALSE);
   priv = flow_grid_get_instance_private(FLOW_GRID(cgrid));
 
-  priv->sort = sort;
+  /* scroll actions configured on the widget take precedence */
+  switch(event->direction)
+  {
+    case GDK_SCROLL_UP:
+      button = 4;
+      break;
+    case GDK_SCROLL_DOWN:
+      button = 5;
+      break;
+    case GDK_SCROLL_LEFT:
+      button = 6;
+      break;
+    case GDK_SCROLL_RIGHT:
+      button = 7;
+      break;
+    default:
+      return FALSE;
+  }
+  if(IS_BASE_WIDGET(widget) && base_widget_get_action(widget,button))
+    return FALSE;
+
+  step = MAX(priv->rows>0 ? priv->rows : priv->cols,1);
+  switch(event->direction)
+  {
+    case GDK_SCROLL_UP:
+    case GDK_SCROLL_LEFT:
+      if(!priv->offset)
+        return FALSE;
+      priv->offset = MAX(priv->offset-step,0);
+      break;
+    case GDK_SCROLL_DOWN:
+    case GDK_SCROLL_RIGHT:
+      priv->offset += step;
+      break;
+    default:
+      return FALSE;
+  }
+  flow_grid_invalidate(cgrid);
+
+  return TRUE;
 }
 
-void flow_grid_attach ( GtkWidget *cgrid, GtkWidget *w )
+/* limit the number of items shown in the grid, items beyond the limit
+ * are not attached to the grid and can be reached by scrolling */
+void flow_grid_set_max ( GtkWidget *cgrid, gint max )
 {
   FlowGridPrivate *priv;
-  GList *children;
+  GtkWidget *parent;
 
   g_return_if_fail(cgrid != NULL);
   g_return_if_fail(IS_FLOW_GRID(cgrid));
-
-  if(!flow_item_get_active(w))
-    return;
-
   priv = flow_grid_get_instance_private(FLOW_GRID(cgrid));
 
-  children = gtk_container_get_children(GTK_CONTAINER(cgrid));
-  if(!children)
-    priv->i=0;
-  g_list_free(children);
-
-  if(priv->rows>0)
-    gtk_grid_attach(GTK_GRID(cgrid),w,
-        (priv->i)/(priv->rows),(priv->i)%(priv->rows),1,1);
-  else
-    gtk_grid_attach(GTK_GRID(cgrid),w,
-        (priv->i)%(priv->cols),(priv->i)/(priv->cols),1,1);
-  priv->i++;
+  priv->max = MAX(max,0);
+  priv->offset = 0;
+  parent = gtk_widget_get_parent(cgrid);
+  if(priv->max && parent && !priv->scroll_h)
+  {
+    gtk_widget_add_events(parent,GDK_SCROLL_MASK);
+    priv->scroll_h = g_signal_connect(G_OBJECT(parent),"scroll-event",
+        G_CALLBACK(flow_grid_scroll_cb),cgrid);
+  }
+  flow_grid_invalidate(cgrid);
 }
 
-void flow_grid_pad ( GtkWidget *cgrid )
+void flow_grid_set_sort ( GtkWidget *cgrid, gboolean sort )
 {
   FlowGridPrivate *priv;
 
   g_return_if_fail(cgrid != NULL);
   g_return_if_fail(IS_FLOW_GRID(cgrid));
+  priv = flow_grid_get_instance_private(FLOW_GRID(cgrid));
+
+  priv->sort = sort;
+}
+
+static void flow_grid_get_pos ( GtkWidget *cgrid, gint i, gint *x, gint *y )
+{
+  FlowGridPrivate *priv;
 
   priv = flow_grid_get_instance_private(FLOW_GRID(cgrid));
- 
+
   if(priv->rows>0)
-    for(;priv->i<priv->rows;priv->i++)
-      gtk_grid_attach(GTK_GRID(cgrid),gtk_label_new(""),0,priv->i,1,1);
+  {
+    *x = i/priv->rows;
+    *y = i%priv->rows;
+  }
   else
-    for(;priv->i<priv->cols;priv->i++)
-      gtk_grid_attach(GTK_GRID(cgrid),gtk_label_new(""),priv->i,0,1,1);
+  {
+    *x = i%priv->cols;
+    *y = i/priv->cols;
+  }
 }
 
-void flow_grid_remove_widget ( GtkWidget *widget, GtkWidget *parent )
+/* place a widget at position i, moving it if it's already attached.
+ * returns TRUE if the widget was attached or moved */
+static gboolean flow_grid_place ( GtkWidget *cgrid, GtkWidget *w, gint i )
 {
-  gtk_container_remove ( GTK_CONTAINER(parent), widget );
+  gint x, y, cx, cy;
+
+  flow_grid_get_pos(cgrid,i,&x,&y);
+
+  if(gtk_widget_get_parent(w)!=cgrid)
+  {
+    gtk_grid_attach(GTK_GRID(cgrid),w,x,y,1,1);
+    return TRUE;
+  }
+
+  gtk_container_child_get(GTK_CONTAINER(cgrid),w,"left-attach",&cx,
+      "top-attach",&cy,NULL);
+  if(cx==x && cy==y)
+    return FALSE;
+
+  gtk_container_child_set(GTK_CONTAINER(cgrid),w,"left-attach",x,
+      "top-attach",y,NULL);
+  return TRUE;
 }
 
-void flow_grid_clean ( GtkWidget *cgrid )
+static void flow_grid_pad ( GtkWidget *cgrid )
 {
-  g_return_if_fail(IS_FLOW_GRID(cgrid));
+  FlowGridPrivate *priv;
+  GList *pad, *next;
+  gint n;
 
-  gtk_container_foreach(GTK_CONTAINER(cgrid),
-      (GtkCallback)flow_grid_remove_widget,cgrid);
+  priv = flow_grid_get_instance_private(FLOW_GRID(cgrid));
+
+  n = priv->rows>0 ? priv->rows : priv->cols;
+  pad = priv->pads;
+  for(;priv->i<n;priv->i++)
+  {
+    if(!pad)
+    {
+      priv->pads = g_list_append(priv->pads,gtk_label_new(""));
+      pad = g_list_last(priv->pads);
+    }
+    flow_grid_place(cgrid,pad->data,priv->i);
+    pad = g_list_next(pad);
+  }
+
+  while(pad)
+  {
+    next = g_list_next(pad);
+    gtk_widget_destroy(pad->data);
+    priv->pads = g_list_delete_link(priv->pads,pad);
+    pad = next;
+  }
+}
+
+/* all grids invalidated within a main loop iteration are updated together
+ * from a single idle callback, ahead of gtk's resize and redraw */
+static gboolean flow_grid_update_dirty ( gpointer data )
+{
+  while(flow_grid_dirty)
+    flow_grid_update(flow_grid_dirty->data);
+  flow_grid_idle = 0;
+
+  return FALSE;
 }
 
 void flow_grid_invalidate ( GtkWidget *self )
@@ -200,7 +309,20 @@ void flow_grid_invalidate ( GtkWidget *self )
   g_return_if_fail(IS_FLOW_GRID(self));
   priv = flow_grid_get_instance_private(FLOW_GRID(self));
 
+  if(priv->invalid)
+    return;
   priv->invalid = TRUE;
+  flow_grid_dirty = g_list_prepend(flow_grid_dirty,self);
+  if(!flow_grid_idle)
+    flow_grid_idle = g_idle_add_full(G_PRIORITY_HIGH_IDLE,
+        flow_grid_update_dirty,NULL,NULL);
+}
+
+void flow_grid_invalidate_item ( GtkWidget *self, GtkWidget *child )
+{
+  if(child)
+    flow_item_set_dirty(child,TRUE);
+  flow_grid_invalidate(self);
 }
 
 void flow_grid_add_child ( GtkWidget *self, GtkWidget *child )
@@ -213,40 +335,116 @@ void flow_grid_add_child ( GtkWidget *self, GtkWidget *child )
 
   priv = flow_grid_get_instance_private(FLOW_GRID(self));
 
-  priv->children = g_list_append(priv->children,child);
+  /* children of a grid are all of the same class, so the index is set up
+   * using the parent hash of the first child added */
+  if(!priv->index)
+    priv->index = g_hash_table_new(FLOW_ITEM_GET_CLASS(child)->parent_hash,
+        FLOW_ITEM_GET_CLASS(child)->parent_equal);
+
+  g_ptr_array_add(priv->children,child);
+  if(flow_item_get_parent(child) &&
+      !g_hash_table_contains(priv->index,flow_item_get_parent(child)))
+    g_hash_table_insert(priv->index,flow_item_get_parent(child),child);
   flow_grid_invalidate(self);
 }
 
 void flow_grid_delete_child ( GtkWidget *self, void *parent )
 {
   FlowGridPrivate *priv;
-  GList *iter;
-  GCompareFunc comp_parent;
+  GtkWidget *child;
 
   if(IS_BASE_WIDGET(self))
     self = base_widget_get_child(self);
   g_return_if_fail(IS_FLOW_GRID(self));
 
   priv = flow_grid_get_instance_private(FLOW_GRID(self));
-  if(!priv->children || !priv->children->data ||
-      !FLOW_ITEM_GET_CLASS(priv->children->data)->comp_parent)
+  if(!priv->index || !parent)
     return;
-  comp_parent = FLOW_ITEM_GET_CLASS(priv->children->data)->comp_parent;
 
-  for(iter=priv->children;iter;iter=g_list_next(iter))
-    if(!comp_parent(flow_item_get_parent(iter->data),parent))
+  child = g_hash_table_lookup(priv->index,parent);
+  if(child)
+  {
+    g_hash_table_remove(priv->index,parent);
+    g_ptr_array_remove(priv->children,child);
+    gtk_widget_destroy(child);
+  }
+  flow_grid_invalidate(self);
+}
+
+#ifdef SFWBAR_UPDATE_TRACE
+/* log the time of each grid update, read back by sfwbar-ipc-mock */
+static void flow_grid_trace ( void )
+{
+  static FILE *trace;
+  static gboolean checked;
+  const gchar *fname;
+
+  if(!checked)
+  {
+    checked = TRUE;
+    fname = g_getenv("SFWBAR_UPDATE_TRACE");
+    if(fname)
+      trace = fopen(fname,"a");
+  }
+  if(!trace)
+    return;
+  fprintf(trace,"%" G_GINT64_FORMAT "\n",g_get_monotonic_time());
+  fflush(trace);
+}
+#endif
+
+/* keep children sorted by re-inserting only the children that changed
+ * since the last update. Sort keys only change on events that invalidate
+ * the item, which flags it for re-sorting, so the remaining children are
+ * known to be in order */
+static void flow_grid_sort ( GtkWidget *self )
+{
+  FlowGridPrivate *priv;
+  GtkWidget *child;
+  GList *dirty, *iter;
+  guint i, j, lo, hi, mid;
+
+  priv = flow_grid_get_instance_private(FLOW_GRID(self));
+
+  dirty = NULL;
+  for(i=0, j=0; i<priv->children->len; i++)
+  {
+    child = g_ptr_array_index(priv->children,i);
+    if(flow_item_get_resort(child))
     {
-      gtk_widget_destroy(iter->data);
-      priv->children = g_list_delete_link(priv->children,iter);
-      break;
+      flow_item_set_resort(child,FALSE);
+      dirty = g_list_prepend(dirty,child);
     }
-  flow_grid_invalidate(self);
+    else
+      g_ptr_array_index(priv->children,j++) = child;
+  }
+  g_ptr_array_set_size(priv->children,j);
+
+  for(iter=dirty; iter; iter=g_list_next(iter))
+  {
+    lo = 0;
+    hi = priv->children->len;
+    while(lo<hi)
+    {
+      mid = (lo+hi)/2;
+      if(flow_item_compare(g_ptr_array_index(priv->children,mid),
+            iter->data,self)<=0)
+        lo = mid+1;
+      else
+        hi = mid;
+    }
+    g_ptr_array_insert(priv->children,lo,iter->data);
+  }
+  g_list_free(dirty);
 }
 
 void flow_grid_update ( GtkWidget *self )
 {
   FlowGridPrivate *priv;
-  GList *iter;
+  GtkWidget *child;
+  gboolean dirty;
+  guint i;
+  gint n;
 
   if(IS_BASE_WIDGET(self))
     self = base_widget_get_child(self);
@@ -257,18 +455,49 @@ void flow_grid_update ( GtkWidget *self )
   if(!priv->invalid)
     return;
   priv->invalid = FALSE;
+  flow_grid_dirty = g_list_remove(flow_grid_dirty,self);
+#ifdef SFWBAR_UPDATE_TRACE
+  flow_grid_trace();
+#endif
 
-  flow_grid_clean(self);
   if(priv->sort)
-    priv->children = g_list_sort_with_data(priv->children,
-        (GCompareDataFunc)flow_item_compare,self);
-  for(iter=priv->children;iter;iter=g_list_next(iter))
+    flow_grid_sort(self);
+
+  /* only reposition children whose cell changed and only restyle children
+   * that were (re)attached or changed since the last update. Children past
+   * the end of the visible window only have their active flag refreshed,
+   * they keep their dirty flag until they are scrolled into view */
+  priv->i = 0;
+  n = 0;
+  for(i=0; i<priv->children->len; i++)
   {
-    flow_item_update(iter->data);
-    flow_grid_attach(self,iter->data);
+    child = g_ptr_array_index(priv->children,i);
+    if(!priv->max || priv->i<priv->max)
+      flow_item_update(child);
+    else
+      flow_item_check_active(child);
+    if(!flow_item_get_active(child) || (priv->max &&
+          (n++<priv->offset || priv->i>=priv->max)))
+    {
+      if(gtk_widget_get_parent(child)==self)
+        gtk_container_remove(GTK_CONTAINER(self),child);
+      continue;
+    }
+
+    dirty = flow_item_get_dirty(child);
+    flow_item_set_dirty(child,FALSE);
+    if(flow_grid_place(self,child,priv->i++) || dirty)
+      css_widget_cascade(child,NULL);
   }
   flow_grid_pad(self);
-  css_widget_cascade(self,NULL);
+
+  /* the window was scrolled past the last item (i.e. items were removed),
+   * shift it back and lay out again */
+  if(priv->max && priv->offset>MAX(n-priv->max,0))
+  {
+    priv->offset = MAX(n-priv->max,0);
+    flow_grid_invalidate(self);
+  }
 }
 
 guint flow_grid_n_children ( GtkWidget *self )
@@ -280,14 +509,12 @@ guint flow_grid_n_children ( GtkWidget *self )
   g_return_val_if_fail(IS_FLOW_GRID(self),0);
   priv = flow_grid_get_instance_private(FLOW_GRID(self));
 
-  return g_list_length(priv->children);
+  return priv->children ? priv->children->len : 0;
 }
 
 gpointer flow_grid_find_child ( GtkWidget *self, gconstpointer parent )
 {
   FlowGridPrivate *priv;
-  GList *iter;
-  GCompareFunc comp_parent;
 
   if(IS_BASE_WIDGET(self))
     self = base_widget_get_child(self);
@@ -295,16 +522,10 @@ gpointer flow_grid_find_child ( GtkWidget *self, gconstpointer parent )
 
   priv = flow_grid_get_instance_private(FLOW_GRID(self));
 
-  if(!priv->children || !priv->children->data ||
-      !FLOW_ITEM_GET_CLASS(priv->children->data)->comp_parent)
+  if(!priv->index || !parent)
     return NULL;
-  comp_parent = FLOW_ITEM_GET_CLASS(priv->children->data)->comp_parent;
-
-  for(iter=priv->children;iter;iter=g_list_next(iter))
-    if(!comp_parent(flow_item_get_parent(iter->data),parent))
-      return iter->data;
 
-  return NULL;
+  return g_hash_table_lookup(priv->index,parent);
 }
 
 static void flow_grid_dnd_data_rec_cb ( GtkWidget *dest, GdkDragContext *ctx,
@@ -314,8 +535,8 @@ static void flow_grid_dnd_data_rec_cb ( GtkWidget *dest, GdkDragContext *ctx,
   FlowGridPrivate *priv;
   GtkWidget *src;
   GtkAllocation alloc;
-  GList *dlist;
   gboolean after;
+  guint i;
 
   if(IS_BASE_WIDGET(parent))
     parent = base_widget_get_child(parent);
@@ -330,14 +551,16 @@ static void flow_grid_dnd_data_rec_cb ( GtkWidget *dest, GdkDragContext *ctx,
   after = ((priv->cols>0 && y>alloc.height/2) ||
       (priv->rows>0 && x>alloc.width/2));
 
-  dlist = g_list_find(priv->children,dest);
-  if(!dlist)
+  if(!g_ptr_array_find(priv->children,dest,NULL) ||
+      !g_ptr_array_remove(priv->children,src))
     return;
+  g_ptr_array_find(priv->children,dest,&i);
+  g_ptr_array_insert(priv->children,after ? i+1 : i,src);
 
-  priv->children = g_list_remove(priv->children, src );
-  priv->children = g_list_insert_before(priv->children,
-      after ? g_list_next(dlist) : dlist, src );
-  flow_item_invalidate(dest);
+  /* pin the user defined order, items added later are sorted after it */
+  for(i=0; i<priv->children->len; i++)
+    flow_item_set_order(g_ptr_array_index(priv->children,i),i+1);
+  flow_grid_invalidate(parent);
 }
 
 static void flow_grid_dnd_data_get_cb ( GtkWidget *widget, GdkDragContext *ctx,
@@ -28,10 +28,14 @@ typedef struct _FlowGridPrivate FlowGridPrivate;
 struct _FlowGridPrivate
 {
   gint cols,rows,i;
+  gint max, offset;
+  gulong scroll_h;
   gboolean limit;
   gboolean invalid;
   gboolean sort;
-  GList *children;
+  GPtrArray *children;
+  GList *pads;
+  GHashTable *index;
   gint (*comp)( GtkWidget *, GtkWidget *, GtkWidget * );
   GtkTargetEntry *dnd_target;
 };
@@ -41,16 +45,15 @@ GType flow_grid_get_type ( void );
 GtkWidget *flow_grid_new( gboolean limit);
 void flow_grid_set_rows ( GtkWidget *cgrid, gint rows );
 void flow_grid_set_cols ( GtkWidget *cgrid, gint cols );
-void flow_grid_attach ( GtkWidget *cgrid, GtkWidget *w );
-void flow_grid_pad ( GtkWidget *cgrid );
-void flow_grid_clean ( GtkWidget *cgrid );
 void flow_grid_add_child ( GtkWidget *self, GtkWidget *child );
 void flow_grid_update ( GtkWidget *self );
 void flow_grid_invalidate ( GtkWidget *self );
+void flow_grid_invalidate_item ( GtkWidget *self, GtkWidget *child );
 void flow_grid_delete_child ( GtkWidget *, void *parent );
 guint flow_grid_n_children ( GtkWidget *self );
 gpointer flow_grid_find_child ( GtkWidget *, gconstpointer parent );
 void flow_grid_child_dnd_enable ( GtkWidget *, GtkWidget *, GtkWidget *);
 void flow_grid_set_sort ( GtkWidget *cgrid, gboolean sort );
+void flow_grid_set_max ( GtkWidget *cgrid, gint max );
 
 #endif
@@ -11,14 +11,10 @@
 G_DEFINE_TYPE_WITH_CODE(FlowItem, flow_item, BASE_WIDGET_TYPE,
     G_ADD_PRIVATE(FlowItem));
 
-static gint flow_item_comp_parent ( gconstpointer p1, gconstpointer p2 )
-{
-  return p2 - p1;
-}
-
 static void flow_item_class_init ( FlowItemClass *kclass )
 {
-  FLOW_ITEM_CLASS(kclass)->comp_parent = flow_item_comp_parent;
+  FLOW_ITEM_CLASS(kclass)->parent_hash = g_direct_hash;
+  FLOW_ITEM_CLASS(kclass)->parent_equal = g_direct_equal;
 }
 
 void flow_item_set_active ( GtkWidget *self, gboolean active )
@@ -41,9 +37,67 @@ gboolean flow_item_get_active ( GtkWidget *self )
   return priv->active;
 }
 
+void flow_item_set_dirty ( GtkWidget *self, gboolean dirty )
+{
+  FlowItemPrivate *priv;
+
+  g_return_if_fail(FLOW_IS_ITEM(self));
+
+  priv = flow_item_get_instance_private(FLOW_ITEM(self));
+  priv->dirty = dirty;
+  if(dirty)
+    priv->resort = TRUE;
+}
+
+gboolean flow_item_get_dirty ( GtkWidget *self )
+{
+  FlowItemPrivate *priv;
+
+  g_return_val_if_fail(FLOW_IS_ITEM(self),FALSE);
+
+  priv = flow_item_get_instance_private(FLOW_ITEM(self));
+  return priv->dirty;
+}
+
+/* the resort flag is set together with the dirty flag, but is cleared once
+ * the item has been repositioned in the sort order, while the dirty flag is
+ * kept until the item is updated */
+void flow_item_set_resort ( GtkWidget *self, gboolean resort )
+{
+  FlowItemPrivate *priv;
+
+  g_return_if_fail(FLOW_IS_ITEM(self));
+
+  priv = flow_item_get_instance_private(FLOW_ITEM(self));
+  priv->resort = resort;
+}
+
+gboolean flow_item_get_resort ( GtkWidget *self )
+{
+  FlowItemPrivate *priv;
+
+  g_return_val_if_fail(FLOW_IS_ITEM(self),FALSE);
+
+  priv = flow_item_get_instance_private(FLOW_ITEM(self));
+  return priv->resort;
+}
+
+/* a non-zero order pins the item to a user defined position (set via
+ * drag-and-drop), pinned items are placed ahead of unpinned ones */
+void flow_item_set_order ( GtkWidget *self, guint order )
+{
+  FlowItemPrivate *priv;
+
+  g_return_if_fail(FLOW_IS_ITEM(self));
+
+  priv = flow_item_get_instance_private(FLOW_ITEM(self));
+  priv->order = order;
+}
+
 static void flow_item_init ( FlowItem *self )
 {
   flow_item_set_active(GTK_WIDGET(self),TRUE);
+  flow_item_set_dirty(GTK_WIDGET(self),TRUE);
 }
 
 void flow_item_update ( GtkWidget *self )
@@ -62,6 +116,15 @@ void flow_item_invalidate ( GtkWidget *self )
     FLOW_ITEM_GET_CLASS(self)->invalidate(self);
 }
 
+/* refresh the active flag without updating the item's widgets */
+void flow_item_check_active ( GtkWidget *self )
+{
+  g_return_if_fail(FLOW_IS_ITEM(self));
+
+  if(FLOW_ITEM_GET_CLASS(self)->check_active)
+    FLOW_ITEM_GET_CLASS(self)->check_active(self);
+}
+
 void *flow_item_get_parent ( GtkWidget *self )
 {
   g_return_val_if_fail(FLOW_IS_ITEM(self),NULL);
@@ -74,9 +137,22 @@ void *flow_item_get_parent ( GtkWidget *self )
 
 gint flow_item_compare ( GtkWidget *p1, GtkWidget *p2, GtkWidget *parent )
 {
+  FlowItemPrivate *priv1, *priv2;
+
   g_return_val_if_fail(FLOW_IS_ITEM(p1),0);
   g_return_val_if_fail(FLOW_IS_ITEM(p2),0);
 
+  priv1 = flow_item_get_instance_private(FLOW_ITEM(p1));
+  priv2 = flow_item_get_instance_private(FLOW_ITEM(p2));
+  if(priv1->order || priv2->order)
+  {
+    if(!priv2->order)
+      return -1;
+    if(!priv1->order)
+      return 1;
+    return priv1->order<priv2->order ? -1 : priv1->order>priv2->order;
+  }
+
   if(!FLOW_ITEM_GET_CLASS(p1)->compare)
     return 0;
 
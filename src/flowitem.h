@@ -16,9 +16,11 @@ struct _FlowItemClass
 
   void (*update) ( GtkWidget *self );
   void (*invalidate) ( GtkWidget *self );
+  void (*check_active) ( GtkWidget *self );
   void* (*get_parent) ( GtkWidget *self );
   gint (*compare) (GtkWidget *, GtkWidget *, GtkWidget *);
-  GCompareFunc comp_parent;
+  GHashFunc parent_hash;
+  GEqualFunc parent_equal;
 };
 
 typedef struct _FlowItemPrivate FlowItemPrivate;
@@ -26,15 +28,24 @@ typedef struct _FlowItemPrivate FlowItemPrivate;
 struct _FlowItemPrivate
 {
   gboolean active;
+  gboolean dirty;
+  gboolean resort;
+  guint order;
 };
 
 GType flow_item_get_type ( void );
 
 void flow_item_update ( GtkWidget *self );
 void flow_item_invalidate ( GtkWidget *self );
+void flow_item_check_active ( GtkWidget *self );
 void *flow_item_get_parent ( GtkWidget *self );
 void flow_item_set_active ( GtkWidget *self, gboolean );
 gboolean flow_item_get_active ( GtkWidget *self );
+void flow_item_set_dirty ( GtkWidget *self, gboolean dirty );
+gboolean flow_item_get_dirty ( GtkWidget *self );
+void flow_item_set_resort ( GtkWidget *self, gboolean resort );
+gboolean flow_item_get_resort ( GtkWidget *self );
+void flow_item_set_order ( GtkWidget *self, guint order );
 gint flow_item_compare ( GtkWidget *p1, GtkWidget *p2, GtkWidget *parent );
 
 #endif
@@ -11,6 +11,15 @@
 #define hypr_ipc_parse_id(x) GINT_TO_POINTER(g_ascii_strtoull(x,NULL,16))
 
 static gchar *ipc_sockaddr;
+static GHashTable *monitor_ws;
+static GHashTable *monitor_geom;
+static GHashTable *ws_monitor;
+static gboolean geom_busy, geom_again;
+static gboolean clients_busy, clients_again;
+static GList *place_pending;
+static gchar *focus_monitor;
+static gchar *active_title;
+static gboolean active_v2, title_v2;
 
 static gpointer hypr_ipc_window_id ( json_object *json )
 {
@@ -48,12 +57,13 @@ static gboolean hypr_ipc_window_geom ( json_object *json, GdkRectangle *res )
   return TRUE;
 }
 
-static gboolean hypr_ipc_request ( gchar *addr, gchar *command, json_object **json )
+static gboolean hypr_ipc_request_raw ( gchar *addr, gchar *command,
+    gchar **reply )
 {
-  gint sock;
-  static gchar buf[1024];
+  GString *str;
+  gchar buf[4096];
   ssize_t rlen;
-  json_tokener *tok;
+  gint sock;
 
   if(!command)
     return FALSE;
@@ -68,19 +78,31 @@ static gboolean hypr_ipc_request ( gchar *addr, gchar *command, json_object **js
     return FALSE;
   }
 
-  if(json)
+  if(reply)
   {
-    *json = NULL;
-    tok = json_tokener_new();
-    while( (rlen = recv(sock,buf,1024,0))>0 )
-      *json = json_tokener_parse_ex(tok,buf,rlen);
-    json_tokener_free(tok);
+    str = g_string_sized_new(sizeof(buf));
+    while( (rlen = recv(sock,buf,sizeof(buf),0))>0 )
+      g_string_append_len(str,buf,rlen);
+    *reply = g_string_free(str,FALSE);
   }
 
   close(sock);
   return TRUE;
 }
 
+static gboolean hypr_ipc_request ( gchar *addr, gchar *command, json_object **json )
+{
+  gchar *reply = NULL;
+
+  if(!hypr_ipc_request_raw(addr,command,json?&reply:NULL))
+    return FALSE;
+
+  if(json)
+    *json = json_tokener_parse(reply);
+  g_free(reply);
+  return TRUE;
+}
+
 static void hypr_ipc_command ( gchar *cmd, ... )
 {
   va_list args;
@@ -97,12 +119,19 @@ static void hypr_ipc_command ( gchar *cmd, ... )
   va_end(args);
 }
 
+/* workspace names are tracked by the pager, only query hyprland for
+ * workspaces it doesn't know about */
 static gchar *hypr_ipc_workspace_name ( gpointer id )
 {
   json_object *json,*ptr;
+  workspace_t *ws;
   gint i;
   gchar *res = NULL;
 
+  ws = pager_workspace_from_id(id);
+  if(ws && ws->name)
+    return g_strdup(ws->name);
+
   if(!hypr_ipc_request(ipc_sockaddr,"j/workspaces",&json) || !json)
     return res;
   if(json_object_is_type(json, json_type_array))
@@ -168,6 +197,27 @@ static gboolean hypr_ipc_get_clients ( gpointer *uid )
   return TRUE;
 }
 
+static gboolean hypr_ipc_set_location ( window_t *win, const gchar *wsname )
+{
+  gpointer wsid;
+
+  if(!g_ascii_strncasecmp(wsname,"special",7))
+  {
+    if(win->state & WS_MINIMIZED)
+      return FALSE;
+    win->state |= WS_MINIMIZED;
+    return TRUE;
+  }
+
+  wsid = pager_workspace_id_from_name((gchar *)wsname);
+  if(wsid)
+    win->workspace = wsid;
+  if(!(win->state & WS_MINIMIZED))
+    return FALSE;
+  win->state &= ~WS_MINIMIZED;
+  return TRUE;
+}
+
 static void hypr_ipc_track_minimized ( gchar *event )
 {
   gpointer *id;
@@ -179,16 +229,41 @@ static void hypr_ipc_track_minimized ( gchar *event )
   if(!win || !ws || *ws!=',')
     return;
 
-  if(ws && !strncmp(ws,",special",8))
-    win->state |= WS_MINIMIZED;
-  else
-    win->state &= ~WS_MINIMIZED;
+  if(hypr_ipc_set_location(win,ws+1))
+    wintree_commit(win);
+}
+
+static GdkRectangle hypr_ipc_monitor_geom ( json_object *json,
+    const gchar *monitor )
+{
+  json_object *iter;
+  GdkRectangle res;
+  gint i, scale;
+
+  res.x = -1;
+  res.y = -1;
+  res.width = -1;
+  res.height = -1;
+  if(!monitor || !json || !json_object_is_type(json, json_type_array))
+    return res;
+
+  for(i=0;i<json_object_array_length(json);i++)
+  {
+    iter = json_object_array_get_idx(json,i);
+    if(!g_strcmp0(monitor,json_string_by_name(iter,"name")))
+    {
+      scale = json_int_by_name(iter,"scale",1);
+      res.width = json_int_by_name(iter,"width",0) / scale;
+      res.height = json_int_by_name(iter,"height",0) / scale;
+    }
+  }
+  return res;
 }
 
 static GdkRectangle hypr_ipc_get_output_geom ( gpointer wsid )
 {
   json_object *json, *iter;
-  gint i, scale;
+  gint i;
   gchar *monitor = NULL;
   GdkRectangle res;
 
@@ -209,50 +284,102 @@ static GdkRectangle hypr_ipc_get_output_geom ( gpointer wsid )
   if(!monitor)
     return res;
   if(hypr_ipc_request(ipc_sockaddr,"j/monitors",&json) && json)
-    if( json_object_is_type(json, json_type_array) )
-      for(i=0;i<json_object_array_length(json);i++)
-      {
-        iter = json_object_array_get_idx(json,i);
-        if(!g_strcmp0(monitor,json_string_by_name(iter,"name")))
-        {
-          scale = json_int_by_name(iter,"scale",1);
-          res.width = json_int_by_name(iter,"width",0) / scale;
-          res.height = json_int_by_name(iter,"height",0) / scale;
-        }
-      }
-  json_object_put(json);
+  {
+    res = hypr_ipc_monitor_geom(json,monitor);
+    json_object_put(json);
+  }
   g_free(monitor);
   return res;
 }
 
-static guint hypr_ipc_get_geom ( workspace_t *ws, GdkRectangle **wins,
-    GdkRectangle *space, gint *focus )
+static void hypr_ipc_request_thread ( GTask *task, gpointer src,
+    gpointer data, GCancellable *cancel )
 {
-  json_object *json, *iter;
-  gint i, n=0;
+  gchar **args = data;
+  gchar *reply = NULL;
 
-  *space = hypr_ipc_get_output_geom(ws->id);
-  if(space->width<0)
-    return 0;
-  if(!hypr_ipc_request(ipc_sockaddr,"j/clients",&json) || !json)
-    return 0;
-  if( json_object_is_type(json, json_type_array) )
+  hypr_ipc_request_raw(args[0],args[1],&reply);
+  g_task_return_pointer(task,reply,g_free);
+}
+
+/* run a request from a worker thread to keep the socket round trip off
+ * the main loop, the callback receives the raw reply via
+ * g_task_propagate_pointer */
+static void hypr_ipc_request_async ( gchar *command, GAsyncReadyCallback cb )
+{
+  GTask *task;
+  gchar *args[] = { ipc_sockaddr, command, NULL };
+
+  task = g_task_new(NULL,NULL,cb,NULL);
+  g_task_set_task_data(task,g_strdupv(args),(GDestroyNotify)g_strfreev);
+  g_task_run_in_thread(task,hypr_ipc_request_thread);
+  g_object_unref(task);
+}
+
+/* window geometry isn't carried by hyprland events, so previews are
+ * refreshed from j/clients. Monitor sizes and the workspace to monitor
+ * map are cached from hypr_ipc_pager_populate */
+
+static void hypr_ipc_update_geom ( void );
+
+static void hypr_ipc_geom_cb ( GObject *src, GAsyncResult *res, gpointer d )
+{
+  GHashTableIter hiter;
+  json_object *clj, *ptr;
+  GdkRectangle *space, *wins;
+  gpointer id, monitor;
+  gchar *reply;
+  gint j, n, focus;
+
+  geom_busy = FALSE;
+  reply = g_task_propagate_pointer(G_TASK(res),NULL);
+  clj = reply?json_tokener_parse(reply):NULL;
+  g_free(reply);
+
+  if(clj && json_object_is_type(clj, json_type_array) && ws_monitor &&
+      monitor_geom)
   {
-    *wins = g_malloc(sizeof(GdkRectangle)*json_object_array_length(json));
-    for(i=0;i<json_object_array_length(json);i++)
+    g_hash_table_iter_init(&hiter,ws_monitor);
+    while(g_hash_table_iter_next(&hiter,&id,&monitor))
     {
-      iter = json_object_array_get_idx(json,i);
-      if(hypr_ipc_workspace_id(iter)==ws->id)
+      space = g_hash_table_lookup(monitor_geom,monitor);
+      if(!space)
+        continue;
+      wins = g_malloc(sizeof(GdkRectangle)*json_object_array_length(clj));
+      focus = -1;
+      n = 0;
+      for(j=0;j<json_object_array_length(clj);j++)
       {
-        hypr_ipc_window_geom(iter,&((*wins)[n]));
-        if(hypr_ipc_window_id(iter)==wintree_get_focus())
-          *focus = n;
-        n++;
+        ptr = json_object_array_get_idx(clj,j);
+        if(hypr_ipc_workspace_id(ptr)==id &&
+            hypr_ipc_window_geom(ptr,&(wins[n])))
+        {
+          if(hypr_ipc_window_id(ptr)==wintree_get_focus())
+            focus = n;
+          n++;
+        }
       }
+      pager_workspace_set_geom(id,space,wins,n,focus);
     }
   }
-  json_object_put(json);
-  return n;
+  json_object_put(clj);
+
+  if(geom_again)
+  {
+    geom_again = FALSE;
+    hypr_ipc_update_geom();
+  }
+}
+
+static void hypr_ipc_update_geom ( void )
+{
+  if(geom_busy)
+  {
+    geom_again = TRUE;
+    return;
+  }
+  geom_busy = TRUE;
+  hypr_ipc_request_async("j/clients",hypr_ipc_geom_cb);
 }
 
 static void hypr_ipc_window_place ( gpointer wid )
@@ -290,18 +417,86 @@ static void hypr_ipc_window_place ( gpointer wid )
   g_free(obs);
 }
 
+static void hypr_ipc_update_clients ( void );
+
+/* openwindow and windowtitle events don't carry the pid or the title, these
+ * are picked up from j/clients. Windows waiting for placement are placed
+ * once their pid is known */
+static void hypr_ipc_clients_cb ( GObject *src, GAsyncResult *res,
+    gpointer d )
+{
+  json_object *json, *ptr;
+  window_t *win;
+  GList *link;
+  gpointer id;
+  gchar *reply;
+  gint i;
+
+  clients_busy = FALSE;
+  reply = g_task_propagate_pointer(G_TASK(res),NULL);
+  json = reply?json_tokener_parse(reply):NULL;
+  g_free(reply);
+
+  if(json && json_object_is_type(json, json_type_array))
+    for(i=0;i<json_object_array_length(json);i++)
+    {
+      ptr = json_object_array_get_idx(json,i);
+      id = hypr_ipc_window_id(ptr);
+      win = wintree_from_id(id);
+      if(!win)
+        continue;
+      if(win->pid<=0)
+        wintree_set_pid(win,json_int_by_name(ptr,"pid",0));
+      wintree_set_title(id,json_string_by_name(ptr,"title"));
+      if( (link = g_list_find(place_pending,id)) )
+      {
+        place_pending = g_list_delete_link(place_pending,link);
+        hypr_ipc_window_place(id);
+      }
+    }
+  json_object_put(json);
+
+  if(clients_again)
+  {
+    clients_again = FALSE;
+    hypr_ipc_update_clients();
+  }
+  else
+    g_clear_pointer(&place_pending,g_list_free);
+}
+
+static void hypr_ipc_update_clients ( void )
+{
+  if(clients_busy)
+  {
+    clients_again = TRUE;
+    return;
+  }
+  clients_busy = TRUE;
+  hypr_ipc_request_async("j/clients",hypr_ipc_clients_cb);
+}
+
 static void hypr_ipc_pager_populate( void )
 {
   json_object *json,*ptr, *iter;
+  GdkRectangle *space;
   gint i, wid;
   workspace_t *ws;
 
   if(!hypr_ipc_request(ipc_sockaddr,"j/workspaces",&json) || !json)
     return;
+  if(!ws_monitor)
+    ws_monitor = g_hash_table_new_full(g_direct_hash,g_direct_equal,NULL,
+        g_free);
+  g_hash_table_remove_all(ws_monitor);
   if(json_object_is_type(json, json_type_array))
     for(i=0;i<json_object_array_length(json);i++)
     {
       ptr = json_object_array_get_idx(json,i);
+      if(json_string_by_name(ptr,"monitor"))
+        g_hash_table_insert(ws_monitor,
+            GINT_TO_POINTER(json_int_by_name(ptr,"id",-1)),
+            g_strdup(json_string_by_name(ptr,"monitor")));
       if(json_int_by_name(ptr,"id",-1)!=-99)
       {
         ws = g_malloc0(sizeof(workspace_t));
@@ -316,20 +511,42 @@ static void hypr_ipc_pager_populate( void )
   json_object_put(json);
   if(!hypr_ipc_request(ipc_sockaddr,"j/monitors",&json) || !json)
     return;
+  if(!monitor_ws)
+    monitor_ws = g_hash_table_new_full(g_str_hash,g_str_equal,g_free,NULL);
+  g_hash_table_remove_all(monitor_ws);
+  if(!monitor_geom)
+    monitor_geom = g_hash_table_new_full(g_str_hash,g_str_equal,g_free,
+        g_free);
+  g_hash_table_remove_all(monitor_geom);
   if(json_object_is_type(json, json_type_array))
     for(i=0;i<json_object_array_length(json);i++)
     {
       iter = json_object_array_get_idx(json,i);
+      if(json_string_by_name(iter,"name"))
+      {
+        space = g_malloc(sizeof(GdkRectangle));
+        *space = hypr_ipc_monitor_geom(json,json_string_by_name(iter,"name"));
+        g_hash_table_insert(monitor_geom,
+            g_strdup(json_string_by_name(iter,"name")),space);
+      }
       if(json_object_object_get_ex(iter,"activeWorkspace",&ptr) && ptr)
       {
         wid = json_int_by_name(ptr,"id",-99);
         if(wid!=-99)
         {
           if(json_bool_by_name(iter,"focused",FALSE))
+          {
             pager_workspace_set_focus(GINT_TO_POINTER(wid));
+            g_free(focus_monitor);
+            focus_monitor = g_strdup(json_string_by_name(iter,"name"));
+          }
           ws = pager_workspace_from_id(GINT_TO_POINTER(wid));
           if(ws)
             ws->visible = TRUE;
+          if(json_string_by_name(iter,"name"))
+            g_hash_table_insert(monitor_ws,
+                g_strdup(json_string_by_name(iter,"name")),
+                GINT_TO_POINTER(wid));
         }
       }
     }
@@ -338,14 +555,88 @@ static void hypr_ipc_pager_populate( void )
   pager_update();
 }
 
+/* a workspace was shown on a monitor, update visibility and focus from
+ * the monitor to workspace map, resync if we don't know enough */
+static void hypr_ipc_workspace_show ( const gchar *name, const gchar *monitor )
+{
+  workspace_t *ws, *prev;
+  gpointer id;
+
+  id = pager_workspace_id_from_name((gchar *)name);
+  ws = id?pager_workspace_from_id(id):NULL;
+  if(!ws || !monitor || !monitor_ws)
+    return hypr_ipc_pager_populate();
+
+  prev = pager_workspace_from_id(g_hash_table_lookup(monitor_ws,monitor));
+  if(prev && prev!=ws)
+  {
+    prev->visible = FALSE;
+    pager_invalidate_all(prev);
+  }
+  if(!ws->visible)
+  {
+    ws->visible = TRUE;
+    pager_invalidate_all(ws);
+  }
+  g_hash_table_insert(monitor_ws,g_strdup(monitor),ws->id);
+  if(!g_strcmp0(monitor,focus_monitor))
+    pager_workspace_set_focus(ws->id);
+}
+
+/* focusedmon>>MONITOR,WORKSPACE */
+static void hypr_ipc_monitor_focus ( gchar *event )
+{
+  gchar *ws;
+
+  ws = strchr(event,',');
+  if(!ws)
+    return;
+  g_free(focus_monitor);
+  focus_monitor = g_strndup(event,ws-event);
+  hypr_ipc_workspace_show(ws+1,focus_monitor);
+}
+
 static void hypr_ipc_track_focus ( void )
 {
-  json_object *json;
+  static const gchar *keys[] = { "address", NULL };
+  const gchar *addr;
+  gchar *reply;
+  JScan *scan;
 
-  if(!hypr_ipc_request(ipc_sockaddr,"j/activewindow",&json) || !json)
+  if(!hypr_ipc_request_raw(ipc_sockaddr,"j/activewindow",&reply))
     return;
-  wintree_set_focus(hypr_ipc_window_id(json));
-  json_object_put(json);
+  scan = jscan_parse(reply,keys);
+  addr = jscan_get_string(scan,"address");
+  wintree_set_focus(addr?hypr_ipc_parse_id(addr):NULL);
+  jscan_free(scan);
+  g_free(reply);
+}
+
+/* activewindow>>CLASS,TITLE, without activewindowv2 we have to ask
+ * hyprland which window this is */
+static void hypr_ipc_active_window ( gchar *event )
+{
+  gchar *title;
+
+  title = strchr(event,',');
+  g_free(active_title);
+  active_title = g_strdup(title?title+1:NULL);
+  if(active_v2)
+    return;
+
+  hypr_ipc_track_focus();
+  wintree_set_title(wintree_get_focus(),active_title);
+}
+
+/* activewindowv2>>ADDRESS */
+static void hypr_ipc_active_window_v2 ( gchar *event )
+{
+  gpointer id;
+
+  active_v2 = TRUE;
+  id = *event?hypr_ipc_parse_id(event):NULL;
+  wintree_set_focus(id);
+  wintree_set_title(id,active_title);
 }
 
 static void hypr_ipc_set_maximized ( gboolean state )
@@ -394,9 +685,11 @@ static void hypr_ipc_unmaximize ( gpointer id )
 
 static void hypr_ipc_minimize ( gpointer id )
 {
+  static const gchar *keys[] = { "workspace.id", NULL };
   window_t *win;
   gpointer focus;
-  json_object *json;
+  gchar *reply;
+  JScan *scan;
 
   win = wintree_from_id(id);
   if(!win || win->state & WS_MINIMIZED)
@@ -405,10 +698,12 @@ static void hypr_ipc_minimize ( gpointer id )
   focus = wintree_get_focus();
   if(focus!=id)
     wintree_set_focus(id);
-  if(hypr_ipc_request(ipc_sockaddr,"j/activewindow",&json) && json)
+  if(hypr_ipc_request_raw(ipc_sockaddr,"j/activewindow",&reply))
   {
-    win->workspace = hypr_ipc_workspace_id(json);
-    json_object_put(json);
+    scan = jscan_parse(reply,keys);
+    win->workspace = GINT_TO_POINTER(jscan_get_int(scan,"workspace.id",0));
+    jscan_free(scan);
+    g_free(reply);
   }
   hypr_ipc_command("dispatch movetoworkspace special");
   hypr_ipc_command("workspace %ld",GPOINTER_TO_INT(win->workspace));
@@ -487,13 +782,55 @@ static struct wintree_api hypr_wintree_api = {
 
 static struct pager_api hypr_pager_api = {
   .set_workspace = hypr_ipc_set_workspace,
-    .get_geom = hypr_ipc_get_geom
+  .update_geom = hypr_ipc_update_geom
 };
 
+/* openwindow>>ADDRESS,WORKSPACE,CLASS,TITLE */
+static void hypr_ipc_window_open ( gchar *event )
+{
+  gchar **fields;
+  window_t *win;
+  gpointer id;
+
+  fields = g_strsplit(event,",",4);
+  if(g_strv_length(fields)<4 || !*fields[0])
+    return g_strfreev(fields);
+
+  id = hypr_ipc_parse_id(fields[0]);
+
+  if(!wintree_from_id(id))
+  {
+    win = wintree_window_init();
+    win->uid = id;
+    hypr_ipc_set_location(win,fields[1]);
+    wintree_window_append(win);
+    wintree_set_app_id(id,fields[2]);
+    wintree_set_title(id,fields[3]);
+    wintree_log(id);
+  }
+  g_strfreev(fields);
+
+  if(wintree_placer_enabled())
+    place_pending = g_list_prepend(place_pending,id);
+  hypr_ipc_update_clients();
+}
+
+/* windowtitlev2>>ADDRESS,TITLE */
+static void hypr_ipc_window_title_v2 ( gchar *event )
+{
+  gchar *title;
+
+  title_v2 = TRUE;
+  title = strchr(event,',');
+  if(title)
+    wintree_set_title(hypr_ipc_parse_id(event),title+1);
+}
+
 static gboolean hypr_ipc_event ( GIOChannel *chan, GIOCondition cond,
     gpointer data)
 {
   gchar *event;
+  gboolean geom = FALSE;
 
   g_io_channel_read_line(chan,&event,NULL,NULL,NULL);
   while(event)
@@ -501,25 +838,43 @@ static gboolean hypr_ipc_event ( GIOChannel *chan, GIOCondition cond,
     if(strchr(event,'\n'))
       *(strchr(event,'\n'))=0;
     g_debug("hypr event: %s",event);
+    if(!strncmp(event,"openwindow>>",12) ||
+        !strncmp(event,"closewindow>>",13) ||
+        !strncmp(event,"movewindow>>",12) ||
+        !strncmp(event,"fullscreen>>",12) ||
+        !strncmp(event,"changefloatingmode>>",20) ||
+        !strncmp(event,"activewindow>>",14) ||
+        !strncmp(event,"activewindowv2>>",16) ||
+        !strncmp(event,"moveworkspace>>",15) ||
+        !strncmp(event,"monitoradded>>",14) ||
+        !strncmp(event,"monitorremoved>>",16))
+      geom = TRUE;
     if(!strncmp(event,"activewindow>>",14))
-      hypr_ipc_track_focus();
+      hypr_ipc_active_window(event+14);
+    else if(!strncmp(event,"activewindowv2>>",16))
+      hypr_ipc_active_window_v2(event+16);
     else if(!strncmp(event,"openwindow>>",12))
-    {
-      hypr_ipc_get_clients(hypr_ipc_parse_id(event+12));
-      hypr_ipc_window_place(hypr_ipc_parse_id(event+12));
-    }
+      hypr_ipc_window_open(event+12);
     else if(!strncmp(event,"closewindow>>",13))
       wintree_window_delete(hypr_ipc_parse_id(event+13));
+    else if(!strncmp(event,"windowtitle>>",13) && !title_v2)
+      hypr_ipc_update_clients();
+    else if(!strncmp(event,"windowtitlev2>>",15))
+      hypr_ipc_window_title_v2(event+15);
     else if(!strncmp(event,"fullscreen>>",12))
       hypr_ipc_set_maximized(g_ascii_digit_value(*(event+12)));
     else if(!strncmp(event,"movewindow>>",12))
       hypr_ipc_track_minimized(event+12);
     else if(!strncmp(event,"workspace>>",11))
-      hypr_ipc_pager_populate();
+      hypr_ipc_workspace_show(event+11,focus_monitor);
     else if(!strncmp(event,"focusedmon>>",12))
-      hypr_ipc_pager_populate();
+      hypr_ipc_monitor_focus(event+12);
     else if(!strncmp(event,"createworkspace>>",17))
       hypr_ipc_pager_populate();
+    else if(!strncmp(event,"moveworkspace>>",15) ||
+        !strncmp(event,"monitoradded>>",14) ||
+        !strncmp(event,"monitorremoved>>",16))
+      hypr_ipc_pager_populate();
     else if(!strncmp(event,"destroyworkspace>>",18))
       pager_workspace_delete(pager_workspace_id_from_name(event+18));
     g_free(event);
@@ -527,9 +882,30 @@ static gboolean hypr_ipc_event ( GIOChannel *chan, GIOCondition cond,
   }
 
   pager_update();
+  if(geom)
+    pager_geom_invalidate();
   return TRUE;
 }
 
+/* hyprland keeps its sockets in $XDG_RUNTIME_DIR/hypr/<signature>/,
+ * older releases used /tmp/hypr/<signature>/ */
+static gchar *hypr_ipc_socket_path ( const gchar *name )
+{
+  const gchar *sig;
+  gchar *path;
+
+  sig = g_getenv("HYPRLAND_INSTANCE_SIGNATURE");
+  if(!sig)
+    return NULL;
+
+  path = g_build_filename(g_get_user_runtime_dir(),"hypr",sig,name,NULL);
+  if(g_file_test(path,G_FILE_TEST_EXISTS))
+    return path;
+  g_free(path);
+
+  return g_build_filename("/tmp","hypr",sig,name,NULL);
+}
+
 void hypr_ipc_init ( void )
 {
   gchar *sockaddr;
@@ -538,19 +914,17 @@ void hypr_ipc_init ( void )
   if(ipc_get())
     return;
 
-  ipc_sockaddr = g_build_filename("/tmp/hypr",
-      g_getenv("HYPRLAND_INSTANCE_SIGNATURE"),".socket.sock",NULL);
-  if(!hypr_ipc_get_clients(NULL))
+  ipc_sockaddr = hypr_ipc_socket_path(".socket.sock");
+  if(!ipc_sockaddr || !hypr_ipc_get_clients(NULL))
   {
-    g_free(ipc_sockaddr);
+    g_clear_pointer(&ipc_sockaddr,g_free);
     return;
   }
 
   ipc_set(IPC_HYPR);
   hypr_ipc_track_focus();
 
-  sockaddr = g_build_filename("/tmp","hypr",
-      g_getenv("HYPRLAND_INSTANCE_SIGNATURE"),".socket2.sock",NULL);
+  sockaddr = hypr_ipc_socket_path(".socket2.sock");
   sock = socket_connect(sockaddr,10);
   if(sock!=-1)
     g_io_add_watch(g_io_channel_unix_new(sock),G_IO_IN,hypr_ipc_event,NULL);
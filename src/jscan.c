@@ -0,0 +1,314 @@
+/* This entire file is licensed under GNU General Public License v3.0
+ *
+ * Copyright 2022 sfwbar maintainers
+ */
+
+/* A single pass json reader for IPC payloads. Only the values of the
+ * requested keys (given as dot separated paths, i.e. "container.id") are
+ * extracted, everything else is skipped without building a json object
+ * tree. Extracted values are stored in a string chunk and are released
+ * together by jscan_free */
+
+#include <glib.h>
+#include "sfwbar.h"
+
+struct jscan {
+  GStringChunk *arena;
+  const gchar **keys;
+  guint n;
+  guint found;
+  gchar *values[];
+};
+
+static const gchar *jscan_ws ( const gchar *p )
+{
+  while(*p==' ' || *p=='\t' || *p=='\n' || *p=='\r')
+    p++;
+  return p;
+}
+
+static const gchar *jscan_skip_string ( const gchar *p )
+{
+  for(p++; *p && *p!='"'; p++)
+    if(*p=='\\' && *(p+1))
+      p++;
+  return *p?p+1:p;
+}
+
+static const gchar *jscan_skip_value ( const gchar *p )
+{
+  gint depth = 0;
+
+  while(*p)
+  {
+    if(*p=='"')
+    {
+      p = jscan_skip_string(p);
+      if(!depth)
+        return p;
+      continue;
+    }
+    if(*p=='{' || *p=='[')
+      depth++;
+    else if(*p=='}' || *p==']')
+    {
+      if(!depth)
+        return p;
+      if(!--depth)
+        return p+1;
+    }
+    else if(!depth && (*p==',' || *p==' ' || *p=='\t' || *p=='\n' ||
+          *p=='\r'))
+      return p;
+    p++;
+  }
+  return p;
+}
+
+static gunichar jscan_hex ( const gchar *p )
+{
+  gunichar res = 0;
+  gint i, d;
+
+  for(i=0;i<4;i++)
+  {
+    d = g_ascii_xdigit_value(p[i]);
+    if(d<0)
+      return 0xFFFD;
+    res = (res<<4) | d;
+  }
+  return res;
+}
+
+static const gchar *jscan_decode_string ( const gchar *p, GString *str )
+{
+  gunichar c, low;
+
+  g_string_truncate(str,0);
+  for(p++; *p && *p!='"'; p++)
+  {
+    if(*p!='\\')
+    {
+      g_string_append_c(str,*p);
+      continue;
+    }
+    p++;
+    switch(*p)
+    {
+      case 'b':
+        g_string_append_c(str,'\b');
+        break;
+      case 'f':
+        g_string_append_c(str,'\f');
+        break;
+      case 'n':
+        g_string_append_c(str,'\n');
+        break;
+      case 'r':
+        g_string_append_c(str,'\r');
+        break;
+      case 't':
+        g_string_append_c(str,'\t');
+        break;
+      case 'u':
+        if(strlen(p)<5)
+          return p+strlen(p);
+        c = jscan_hex(p+1);
+        p+=4;
+        if(c>=0xD800 && c<0xDC00 && *(p+1)=='\\' && *(p+2)=='u' &&
+            strlen(p)>=7)
+        {
+          low = jscan_hex(p+3);
+          if(low>=0xDC00 && low<0xE000)
+          {
+            c = 0x10000 + ((c-0xD800)<<10) + (low-0xDC00);
+            p+=6;
+          }
+        }
+        g_string_append_unichar(str,c);
+        break;
+      case '\0':
+        return p;
+      default:
+        g_string_append_c(str,*p);
+        break;
+    }
+  }
+  return *p?p+1:p;
+}
+
+static const gchar *jscan_value ( JScan *scan, const gchar *p, gint idx )
+{
+  static GString *str;
+  const gchar *end;
+
+  scan->found++;
+  if(*p=='"')
+  {
+    if(!str)
+      str = g_string_sized_new(256);
+    end = jscan_decode_string(p,str);
+    scan->values[idx] = g_string_chunk_insert_len(scan->arena,str->str,
+        str->len);
+    return end;
+  }
+
+  end = jscan_skip_value(p);
+  if(*p!='{' && *p!='[' && strncmp(p,"null",4))
+    scan->values[idx] = g_string_chunk_insert_len(scan->arena,p,end-p);
+  return end;
+}
+
+static gint jscan_match ( JScan *scan, GString *path, gboolean *prefix )
+{
+  gint i, res = -1;
+
+  *prefix = FALSE;
+  for(i=0;i<scan->n;i++)
+    if(!strncmp(scan->keys[i],path->str,path->len))
+    {
+      if(!scan->keys[i][path->len] && !scan->values[i])
+        res = i;
+      else if(scan->keys[i][path->len]=='.')
+        *prefix = TRUE;
+    }
+  return res;
+}
+
+static const gchar *jscan_object ( JScan *scan, const gchar *p,
+    GString *path )
+{
+  const gchar *key;
+  gsize plen = path->len;
+  gboolean prefix;
+  gint idx;
+
+  p++;
+  while(*p && scan->found<scan->n)
+  {
+    p = jscan_ws(p);
+    if(*p=='}')
+    {
+      p++;
+      break;
+    }
+    if(*p==',')
+    {
+      p++;
+      continue;
+    }
+    if(*p!='"')
+    {
+      p += strlen(p);
+      break;
+    }
+
+    key = p+1;
+    p = jscan_skip_string(p);
+    g_string_truncate(path,plen);
+    if(plen)
+      g_string_append_c(path,'.');
+    g_string_append_len(path,key,MAX(p-key-1,0));
+
+    p = jscan_ws(p);
+    if(*p!=':')
+    {
+      p += strlen(p);
+      break;
+    }
+    p = jscan_ws(p+1);
+
+    idx = jscan_match(scan,path,&prefix);
+    if(*p=='{' && prefix)
+      p = jscan_object(scan,p,path);
+    else if(idx>=0)
+      p = jscan_value(scan,p,idx);
+    else
+      p = jscan_skip_value(p);
+  }
+  g_string_truncate(path,plen);
+  return p;
+}
+
+JScan *jscan_parse ( const gchar *json, const gchar **keys )
+{
+  JScan *scan;
+  GString *path;
+  const gchar *p;
+  guint n;
+
+  for(n=0; keys && keys[n]; n++);
+
+  scan = g_malloc0(sizeof(JScan) + n * sizeof(gchar *));
+  scan->arena = g_string_chunk_new(256);
+  scan->keys = keys;
+  scan->n = n;
+
+  if(!json || !n)
+    return scan;
+
+  p = jscan_ws(json);
+  if(*p=='{')
+  {
+    path = g_string_sized_new(64);
+    jscan_object(scan,p,path);
+    g_string_free(path,TRUE);
+  }
+
+  return scan;
+}
+
+static gint jscan_index ( JScan *scan, const gchar *key )
+{
+  gint i;
+
+  if(!scan)
+    return -1;
+
+  for(i=0;i<scan->n;i++)
+    if(!g_strcmp0(scan->keys[i],key))
+      return i;
+  return -1;
+}
+
+const gchar *jscan_get_string ( JScan *scan, const gchar *key )
+{
+  gint idx;
+
+  idx = jscan_index(scan,key);
+  if(idx<0)
+    return NULL;
+  return scan->values[idx];
+}
+
+gint64 jscan_get_int ( JScan *scan, const gchar *key, gint64 defval )
+{
+  const gchar *val;
+
+  val = jscan_get_string(scan,key);
+  if(!val)
+    return defval;
+  return g_ascii_strtoll(val,NULL,10);
+}
+
+gboolean jscan_get_bool ( JScan *scan, const gchar *key, gboolean defval )
+{
+  const gchar *val;
+
+  val = jscan_get_string(scan,key);
+  if(!val)
+    return defval;
+  if(!g_strcmp0(val,"true"))
+    return TRUE;
+  if(!g_strcmp0(val,"false"))
+    return FALSE;
+  return g_ascii_strtoll(val,NULL,10)!=0;
+}
+
+void jscan_free ( JScan *scan )
+{
+  if(!scan)
+    return;
+  g_string_chunk_free(scan->arena);
+  g_free(scan);
+}
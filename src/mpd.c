@@ -6,11 +6,75 @@
 #include <glib.h>
 #include <gio/gio.h>
 #include <gio/gunixsocketaddress.h>
+#include <string.h>
 #include "sfwbar.h"
 #include "basewidget.h"
 
 static GSocketConnection *mpd_ipc_sock;
 static GSocketConnection *mpd_cmd_sock;
+static GIOChannel *mpd_cmd_chan;
+static GString *mpd_cmd_buff;
+static gchar *mpd_cmd_out;
+static gsize mpd_cmd_sent;
+static gboolean mpd_cmd_retry;
+static gchar *mpd_cmd_path;
+static gboolean mpd_cmd_ready;
+static gint mpd_cmd_count;
+static guint mpd_cmd_watch;
+static guint mpd_cmd_out_watch;
+static guint mpd_cmd_timer;
+
+#define MPD_CMD_DELAY 20
+
+/* playback position as of the last status reply, used to interpolate
+ * elapsed time between status updates */
+static gdouble mpd_elapsed, mpd_duration;
+static gint64 mpd_stamp;
+static gboolean mpd_playing;
+
+static void mpd_ipc_parse_status ( const gchar *line )
+{
+  const gchar *ptr;
+
+  if(g_str_has_prefix(line,"state: "))
+  {
+    mpd_playing = g_str_has_prefix(line+7,"play");
+    mpd_elapsed = 0;
+    mpd_duration = 0;
+    mpd_stamp = g_get_monotonic_time();
+  }
+  else if(g_str_has_prefix(line,"elapsed: "))
+  {
+    mpd_elapsed = g_ascii_strtod(line+9,NULL);
+    mpd_stamp = g_get_monotonic_time();
+  }
+  else if(g_str_has_prefix(line,"duration: "))
+    mpd_duration = g_ascii_strtod(line+10,NULL);
+  else if(g_str_has_prefix(line,"time: ") && !mpd_duration &&
+      (ptr = strchr(line,':')) && (ptr = strchr(ptr+1,':')))
+    mpd_duration = g_ascii_strtod(ptr+1,NULL);
+}
+
+gdouble mpd_ipc_get_value ( const gchar *field )
+{
+  gdouble elapsed;
+
+  elapsed = mpd_elapsed;
+  if(mpd_playing)
+    elapsed += (gdouble)(g_get_monotonic_time() - mpd_stamp)/G_USEC_PER_SEC;
+  if(mpd_duration>0)
+    elapsed = MIN(elapsed,mpd_duration);
+
+  if(!g_ascii_strcasecmp(field,"elapsed"))
+    return elapsed;
+  if(!g_ascii_strcasecmp(field,"duration"))
+    return mpd_duration;
+  if(!g_ascii_strcasecmp(field,"progress"))
+    return mpd_duration>0?elapsed/mpd_duration:0;
+  if(!g_ascii_strcasecmp(field,"playing"))
+    return mpd_playing;
+  return 0;
+}
 
 gboolean mpd_ipc_event ( GIOChannel *chan, GIOCondition cond, gpointer file )
 {
@@ -30,6 +94,9 @@ gboolean mpd_ipc_event ( GIOChannel *chan, GIOCondition cond, gpointer file )
       mpd_ipc_sock = NULL;
       r = 0;
     }
+    mpd_playing = FALSE;
+    mpd_elapsed = 0;
+    mpd_duration = 0;
     return FALSE;
   }
 
@@ -37,14 +104,14 @@ gboolean mpd_ipc_event ( GIOChannel *chan, GIOCondition cond, gpointer file )
   {
     if( file )
     {
-      scanner_update_file( chan, file );
+      scanner_update_file_hook( chan, file, mpd_ipc_parse_status );
       base_widget_emit_trigger("mpd");
     }
 
     if(!r)
       s = g_io_channel_write_chars(chan,"status\ncurrentsong\n",-1,NULL,NULL);
     else
-      s = g_io_channel_write_chars(chan,"idle player\n",-1,NULL,NULL);
+      s = g_io_channel_write_chars(chan,"idle player mixer options playlist\n",-1,NULL,NULL);
     g_io_channel_flush(chan,NULL);
     if(s != G_IO_STATUS_NORMAL)
       g_debug("mpd: failed to write to mpd socket");
@@ -153,6 +220,8 @@ void mpd_ipc_init ( ScanFile *file )
 {
   static GIOChannel *chan;
 
+  if(!mpd_cmd_path)
+    mpd_cmd_path = g_strdup(file->fname);
   chan = mpd_ipc_open ( file->fname, (gpointer *) &mpd_ipc_sock );
   if(chan)
     g_io_add_watch(chan,G_IO_IN | G_IO_ERR | G_IO_HUP,mpd_ipc_event,file);
@@ -160,41 +229,164 @@ void mpd_ipc_init ( ScanFile *file )
   g_timeout_add (1000,(GSourceFunc )mpd_ipc_reconnect,file);
 }
 
-gboolean mpd_ipc_command_cb ( GIOChannel *chan, GIOCondition cond, gpointer command )
+static void mpd_ipc_command_close ( void )
+{
+  if(!mpd_cmd_chan)
+    return;
+  if(mpd_cmd_watch)
+    g_source_remove(mpd_cmd_watch);
+  if(mpd_cmd_out_watch)
+    g_source_remove(mpd_cmd_out_watch);
+  g_io_channel_shutdown(mpd_cmd_chan, FALSE, NULL);
+  g_io_channel_unref(mpd_cmd_chan);
+  g_clear_object(&mpd_cmd_sock);
+  mpd_cmd_chan = NULL;
+  mpd_cmd_watch = 0;
+  mpd_cmd_out_watch = 0;
+  mpd_cmd_ready = FALSE;
+}
+
+static gboolean mpd_ipc_command_flush ( gpointer data );
+static void mpd_ipc_command_write ( void );
+
+static gboolean mpd_ipc_command_out_cb ( GIOChannel *chan,
+    GIOCondition cond, gpointer data )
+{
+  mpd_cmd_out_watch = 0;
+  mpd_ipc_command_write();
+  return FALSE;
+}
+
+/* queued commands are framed into a batch (mpd_cmd_out), which is kept
+ * until all of it has been written. A full socket buffer only delays the
+ * rest of the batch, while a failed write resends it over a new connection
+ * once, unless part of it had been sent already */
+static void mpd_ipc_command_write ( void )
+{
+  GIOStatus s;
+  gsize written = 0;
+
+  if(!mpd_cmd_ready)
+    return;
+
+  if(!mpd_cmd_out)
+  {
+    if(!mpd_cmd_count)
+      return;
+    if(mpd_cmd_count>1)
+      mpd_cmd_out = g_strconcat("command_list_begin\n",mpd_cmd_buff->str,
+          "command_list_end\n",NULL);
+    else
+      mpd_cmd_out = g_strdup(mpd_cmd_buff->str);
+    g_debug("mpd: sending %d command(s)",mpd_cmd_count);
+    g_string_truncate(mpd_cmd_buff,0);
+    mpd_cmd_count = 0;
+    mpd_cmd_sent = 0;
+  }
+
+  s = g_io_channel_write_chars(mpd_cmd_chan, mpd_cmd_out+mpd_cmd_sent, -1,
+      &written, NULL);
+  mpd_cmd_sent += written;
+  if(s == G_IO_STATUS_NORMAL || s == G_IO_STATUS_AGAIN)
+    s = g_io_channel_flush(mpd_cmd_chan, NULL);
+
+  if(s == G_IO_STATUS_NORMAL || s == G_IO_STATUS_AGAIN)
+  {
+    if(s == G_IO_STATUS_AGAIN || mpd_cmd_out[mpd_cmd_sent])
+    {
+      if(!mpd_cmd_out_watch)
+        mpd_cmd_out_watch = g_io_add_watch(mpd_cmd_chan, G_IO_OUT,
+            mpd_ipc_command_out_cb, NULL);
+      return;
+    }
+    g_clear_pointer(&mpd_cmd_out,g_free);
+    mpd_cmd_retry = FALSE;
+    mpd_ipc_command_write();
+    return;
+  }
+
+  /* the server may have dropped an idle connection, reconnect once */
+  g_debug("mpd: Failed to write to command socket");
+  mpd_ipc_command_close();
+  if(!mpd_cmd_retry && !mpd_cmd_sent)
+  {
+    mpd_cmd_retry = TRUE;
+    if(!mpd_cmd_timer)
+      mpd_cmd_timer = g_idle_add(mpd_ipc_command_flush,NULL);
+    return;
+  }
+  g_clear_pointer(&mpd_cmd_out,g_free);
+  mpd_cmd_retry = FALSE;
+}
+
+static gboolean mpd_ipc_command_cb ( GIOChannel *chan, GIOCondition cond,
+    gpointer data )
 {
   gchar *str;
+  GIOStatus s = G_IO_STATUS_NORMAL;
 
-  if(g_io_channel_read_to_end(chan, &str, NULL, NULL) != G_IO_STATUS_NORMAL )
-    g_debug("mpd: Failed to read from socket");
-  g_free(str);
-  str = g_strconcat( command, "\n", NULL );
-  if( g_io_channel_write_chars ( chan, str, -1, NULL, NULL ) != 
-      G_IO_STATUS_NORMAL )
-    g_debug("mpd: Command \"%s\". Failed to write to socket",
-        (gchar *)command);
-  g_io_channel_flush( chan, NULL );
-  g_free(str);
+  if( cond & G_IO_IN )
+    while( (s = g_io_channel_read_line(chan, &str, NULL, NULL, NULL)) ==
+        G_IO_STATUS_NORMAL )
+    {
+      if(g_str_has_prefix(str,"OK MPD "))
+        mpd_cmd_ready = TRUE;
+      else if(g_str_has_prefix(str,"ACK "))
+        g_debug("mpd: command error: %s",g_strchomp(str));
+      g_free(str);
+    }
 
-  g_io_channel_shutdown(chan, FALSE, NULL);
-  g_io_channel_unref(chan);
+  if( cond & G_IO_ERR || cond & G_IO_HUP || s == G_IO_STATUS_EOF ||
+      s == G_IO_STATUS_ERROR )
+  {
+    g_debug("mpd: command connection closed");
+    mpd_cmd_watch = 0;
+    mpd_ipc_command_close();
+    if(mpd_cmd_sent)
+      g_clear_pointer(&mpd_cmd_out,g_free);
+    return FALSE;
+  }
+
+  mpd_ipc_command_write();
+  return TRUE;
+}
+
+static gboolean mpd_ipc_command_flush ( gpointer data )
+{
+  mpd_cmd_timer = 0;
 
-  g_object_unref(mpd_cmd_sock);
+  if(!mpd_cmd_chan)
+  {
+    mpd_cmd_chan = mpd_ipc_open ( mpd_cmd_path, (gpointer *) &mpd_cmd_sock );
+    if(!mpd_cmd_chan)
+    {
+      g_string_truncate(mpd_cmd_buff,0);
+      g_clear_pointer(&mpd_cmd_out,g_free);
+      mpd_cmd_count = 0;
+      mpd_cmd_retry = FALSE;
+      return FALSE;
+    }
+    g_io_channel_set_flags(mpd_cmd_chan,G_IO_FLAG_NONBLOCK,NULL);
+    mpd_cmd_watch = g_io_add_watch(mpd_cmd_chan,G_IO_IN | G_IO_ERR | G_IO_HUP,
+        mpd_ipc_command_cb,NULL);
+  }
+  mpd_ipc_command_write();
 
   return FALSE;
 }
 
+/* commands are sent over a persistent connection. Commands issued within
+ * MPD_CMD_DELAY ms of each other are sent as a single command list */
 void mpd_ipc_command ( gchar *command )
 {
-  GIOChannel *chan;
-
   if(!command)
     return;
 
-  chan = mpd_ipc_open ( NULL, (gpointer *) &mpd_cmd_sock );
-
-  if(!chan)
-    return;
+  if(!mpd_cmd_buff)
+    mpd_cmd_buff = g_string_new(NULL);
+  g_string_append_printf(mpd_cmd_buff,"%s\n",command);
+  mpd_cmd_count++;
 
-  g_io_add_watch(chan,G_IO_IN | G_IO_ERR | G_IO_HUP,
-      mpd_ipc_command_cb,command);
+  if(!mpd_cmd_timer)
+    mpd_cmd_timer = g_timeout_add(MPD_CMD_DELAY,mpd_ipc_command_flush,NULL);
 }
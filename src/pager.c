@@ -11,12 +11,14 @@
 G_DEFINE_TYPE_WITH_CODE (Pager, pager, BASE_WIDGET_TYPE, G_ADD_PRIVATE (Pager));
 
 #define PAGER_PIN_ID (GINT_TO_POINTER(-1))
+#define PAGER_GEOM_DELAY 100
 
 static struct pager_api api;
 static GList *pagers;
 static GList *global_pins;
 static workspace_t *focus;
 static GList *workspaces;
+static guint geom_timer;
 
 void pager_api_register ( struct pager_api *new )
 {
@@ -29,12 +31,41 @@ void pager_set_workspace ( workspace_t *ws )
     api.set_workspace(ws);
 }
 
+/* returns the cached geometry of a workspace, the window array is owned
+ * by the workspace and must not be freed by the caller */
 guint pager_get_geom ( workspace_t *ws, GdkRectangle **wins, GdkRectangle *spc,
     gint *focus)
 {
-  if(api.get_geom)
-    return api.get_geom(ws,wins,spc,focus);
-  return 0;
+  *wins = ws->wins;
+  *spc = ws->space;
+  *focus = ws->wfocus;
+  return ws->nwins;
+}
+
+static gboolean pager_geom_update ( gpointer data )
+{
+  geom_timer = 0;
+  if(api.update_geom)
+    api.update_geom();
+  return FALSE;
+}
+
+/* schedule a refresh of the geometry cache, only needed if any pager
+ * shows previews */
+void pager_geom_invalidate ( void )
+{
+  GList *iter;
+
+  if(geom_timer || !api.update_geom)
+    return;
+
+  for(iter=pagers;iter;iter=g_list_next(iter))
+    if(g_object_get_data(G_OBJECT(base_widget_get_child(iter->data)),
+          "preview"))
+      break;
+
+  if(iter)
+    geom_timer = g_timeout_add(PAGER_GEOM_DELAY,pager_geom_update,NULL);
 }
 
 static GtkWidget *pager_get_child ( GtkWidget *self )
@@ -158,6 +189,28 @@ void pager_workspace_set_focus ( gpointer id )
   pager_invalidate_all(focus);
 }
 
+void pager_workspace_set_geom ( gpointer id, GdkRectangle *space,
+    GdkRectangle *wins, guint n, gint focus )
+{
+  workspace_t *ws;
+
+  ws = pager_workspace_from_id(id);
+  if(!ws)
+    return g_free(wins);
+
+  if(ws->nwins==n && ws->wfocus==focus &&
+      !memcmp(&ws->space,space,sizeof(GdkRectangle)) &&
+      (!n || !memcmp(ws->wins,wins,n*sizeof(GdkRectangle))))
+    return g_free(wins);
+
+  g_free(ws->wins);
+  ws->space = *space;
+  ws->wins = wins;
+  ws->nwins = n;
+  ws->wfocus = focus;
+  pager_item_redraw_previews(ws);
+}
+
 void pager_workspace_delete ( gpointer id )
 {
   GList *iter, *item;
@@ -184,6 +237,7 @@ void pager_workspace_delete ( gpointer id )
   {
     g_list_foreach(pagers,(GFunc)flow_grid_delete_child,ws);
     g_free(ws->name);
+    g_free(ws->wins);
     g_free(ws);
     workspaces = g_list_delete_link(workspaces,item);
   }
@@ -240,7 +294,7 @@ void pager_populate ( void )
           (GCompareFunc)pager_comp_name))
 
     {
-      ws = g_malloc(sizeof(workspace_t));
+      ws = g_malloc0(sizeof(workspace_t));
       ws->id = PAGER_PIN_ID;
       ws->name = g_strdup(item->data);
       ws->visible = FALSE;
@@ -249,6 +303,7 @@ void pager_populate ( void )
     }
 
   g_list_foreach(pagers,(GFunc)flow_grid_update,NULL);
+  pager_geom_invalidate();
 }
 
 void pager_update ( void )
@@ -38,11 +38,15 @@ typedef struct workspace_s {
   gboolean visible;
   gboolean focused;
   GtkWidget *pager;
+  GdkRectangle space;
+  GdkRectangle *wins;
+  guint nwins;
+  gint wfocus;
 } workspace_t;
 
 struct pager_api {
   void (*set_workspace) ( workspace_t *);
-  guint (*get_geom) ( workspace_t *, GdkRectangle **, GdkRectangle *, gint *);
+  void (*update_geom) ( void );
 };
 
 GtkWidget *pager_new();
@@ -59,5 +63,8 @@ gpointer pager_workspace_id_from_name ( gchar *name );
 void pager_api_register ( struct pager_api *new );
 void pager_set_workspace ( workspace_t *ws );
 guint pager_get_geom ( workspace_t *, GdkRectangle **, GdkRectangle *, gint * );
+void pager_workspace_set_geom ( gpointer id, GdkRectangle *space,
+    GdkRectangle *wins, guint n, gint focus );
+void pager_geom_invalidate ( void );
 
 #endif
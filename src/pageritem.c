@@ -9,6 +9,18 @@
 
 G_DEFINE_TYPE_WITH_CODE (PagerItem, pager_item, FLOW_ITEM_TYPE, G_ADD_PRIVATE (PagerItem));
 
+static void pager_item_check_active ( GtkWidget *self )
+{
+  PagerItemPrivate *priv;
+
+  g_return_if_fail(IS_PAGER_ITEM(self));
+  priv = pager_item_get_instance_private(PAGER_ITEM(self));
+
+  flow_item_set_active(self, priv->ws->id != GINT_TO_POINTER(-1) ||
+      g_list_find_custom(g_object_get_data(G_OBJECT(priv->pager),"pins"),
+        priv->ws->name, (GCompareFunc)g_strcmp0)!=NULL);
+}
+
 void pager_item_update ( GtkWidget *self )
 {
   PagerItemPrivate *priv;
@@ -33,9 +45,7 @@ void pager_item_update ( GtkWidget *self )
   gtk_widget_unset_state_flags(gtk_bin_get_child(GTK_BIN(self)),
       GTK_STATE_FLAG_PRELIGHT);
 
-  flow_item_set_active(self, priv->ws->id != GINT_TO_POINTER(-1) ||
-      g_list_find_custom(g_object_get_data(G_OBJECT(priv->pager),"pins"),
-        priv->ws->name, (GCompareFunc)g_strcmp0)!=NULL);
+  pager_item_check_active(self);
 
   priv->invalid = FALSE;
 }
@@ -53,6 +63,7 @@ workspace_t *pager_item_get_workspace ( GtkWidget *self )
 static void pager_item_class_init ( PagerItemClass *kclass )
 {
   FLOW_ITEM_CLASS(kclass)->update = pager_item_update;
+  FLOW_ITEM_CLASS(kclass)->check_active = pager_item_check_active;
   FLOW_ITEM_CLASS(kclass)->get_parent = (void * (*)(GtkWidget *))pager_item_get_workspace;
   FLOW_ITEM_CLASS(kclass)->compare = pager_item_compare;
 }
@@ -103,11 +114,28 @@ static gboolean pager_item_draw_preview ( GtkWidget *widget, cairo_t *cr,
         (int)(wins[i].height*h/spc.height));
     cairo_stroke(cr);
   }
-  g_free(wins);
 
   return TRUE;
 }
 
+static GList *pager_item_previews;
+
+static void pager_item_preview_destroy_cb ( GtkWidget *preview, gpointer d )
+{
+  pager_item_previews = g_list_remove(pager_item_previews,preview);
+}
+
+/* redraw previews of a workspace shown in tooltips once its geometry
+ * changes */
+void pager_item_redraw_previews ( workspace_t *ws )
+{
+  GList *iter;
+
+  for(iter=pager_item_previews;iter;iter=g_list_next(iter))
+    if(g_object_get_data(G_OBJECT(iter->data),"workspace")==ws)
+      gtk_widget_queue_draw(iter->data);
+}
+
 static gboolean pager_item_draw_tooltip ( GtkWidget *widget, gint x, gint y,
     gboolean kbmode, GtkTooltip *tooltip, workspace_t *ws )
 {
@@ -115,6 +143,10 @@ static gboolean pager_item_draw_tooltip ( GtkWidget *widget, gint x, gint y,
 
   button = gtk_button_new();
   g_signal_connect(button,"draw",G_CALLBACK(pager_item_draw_preview),ws);
+  g_object_set_data(G_OBJECT(button),"workspace",ws);
+  g_signal_connect(button,"destroy",
+      G_CALLBACK(pager_item_preview_destroy_cb),NULL);
+  pager_item_previews = g_list_prepend(pager_item_previews,button);
   gtk_widget_set_name(button, "pager_preview");
   gtk_tooltip_set_custom(tooltip,button);
   return TRUE;
@@ -176,6 +208,6 @@ void pager_item_invalidate ( GtkWidget *self )
   g_return_if_fail(IS_PAGER_ITEM(self));
   priv = pager_item_get_instance_private(PAGER_ITEM(self));
 
-  flow_grid_invalidate(priv->pager);
+  flow_grid_invalidate_item(priv->pager,self);
   priv->invalid = TRUE;
 }
@@ -41,5 +41,6 @@ workspace_t *pager_item_get_workspace ( GtkWidget *self );
 void pager_item_update ( GtkWidget *self );
 gint pager_item_compare ( GtkWidget *, GtkWidget *, GtkWidget * );
 void pager_item_invalidate ( GtkWidget *self );
+void pager_item_redraw_previews ( workspace_t *ws );
 
 #endif
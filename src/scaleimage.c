@@ -7,12 +7,105 @@
 #include "scaleimage.h"
 #include <gtk/gtk.h>
 #include <gio/gdesktopappinfo.h>
+#include <sys/stat.h>
 
 G_DEFINE_TYPE_WITH_CODE (ScaleImage, scale_image, GTK_TYPE_IMAGE,
     G_ADD_PRIVATE (ScaleImage));
 
 int scale_image_update ( GtkWidget *self );
 
+/* rendered images are shared between all ScaleImage widgets via an LRU
+ * cache of cairo surfaces keyed by image source, size, scale and color */
+struct si_cache_entry {
+  gchar *key;
+  cairo_surface_t *cs;
+  gsize size;
+};
+
+static GHashTable *si_cache;
+static GQueue si_cache_lru = G_QUEUE_INIT;
+static gsize si_cache_size;
+static gsize si_cache_limit = 4*1024*1024;
+
+static void scale_image_cache_entry_free ( struct si_cache_entry *entry )
+{
+  si_cache_size -= entry->size;
+  cairo_surface_destroy(entry->cs);
+  g_free(entry->key);
+  g_free(entry);
+}
+
+void scale_image_cache_clear ( void )
+{
+  struct si_cache_entry *entry;
+
+  if(si_cache)
+    g_hash_table_remove_all(si_cache);
+  while( (entry = g_queue_pop_head(&si_cache_lru)) )
+    scale_image_cache_entry_free(entry);
+}
+
+static void scale_image_theme_changed ( GtkIconTheme *theme, gpointer data )
+{
+  scale_image_cache_clear();
+}
+
+void scale_image_cache_set_limit ( gsize limit )
+{
+  si_cache_limit = limit;
+}
+
+static cairo_surface_t *scale_image_cache_lookup ( const gchar *key )
+{
+  GList *link;
+
+  if(!si_cache || !key)
+    return NULL;
+
+  link = g_hash_table_lookup(si_cache,key);
+  if(!link)
+    return NULL;
+
+  g_queue_unlink(&si_cache_lru,link);
+  g_queue_push_head_link(&si_cache_lru,link);
+  return ((struct si_cache_entry *)link->data)->cs;
+}
+
+static void scale_image_cache_insert ( const gchar *key, cairo_surface_t *cs,
+    gsize size )
+{
+  struct si_cache_entry *entry;
+
+  if(!key || !cs || size>si_cache_limit)
+    return;
+
+  if(!si_cache)
+  {
+    si_cache = g_hash_table_new(g_str_hash,g_str_equal);
+    g_signal_connect(G_OBJECT(gtk_icon_theme_get_default()),"changed",
+        G_CALLBACK(scale_image_theme_changed),NULL);
+  }
+
+  if(g_hash_table_contains(si_cache,key))
+    return;
+
+  while(si_cache_size + size > si_cache_limit &&
+      (entry = g_queue_pop_tail(&si_cache_lru)))
+  {
+    g_hash_table_remove(si_cache,entry->key);
+    scale_image_cache_entry_free(entry);
+  }
+
+  entry = g_malloc(sizeof(struct si_cache_entry));
+  entry->key = g_strdup(key);
+  entry->cs = cairo_surface_reference(cs);
+  entry->size = size;
+  si_cache_size += size;
+  g_queue_push_head(&si_cache_lru,entry);
+  g_hash_table_insert(si_cache,entry->key,g_queue_peek_head_link(
+        &si_cache_lru));
+}
+
 static void scale_image_get_preferred_width ( GtkWidget *self, gint *m,
     gint *n )
 {
@@ -37,6 +130,15 @@ static void scale_image_get_preferred_height ( GtkWidget *self, gint *m,
   *n = priv->rawh;
 }
 
+static void scale_image_pixbuf_func_clear ( ScaleImagePrivate *priv )
+{
+  if(priv->pixbuf_destroy && priv->pixbuf_data)
+    priv->pixbuf_destroy(priv->pixbuf_data);
+  priv->pixbuf_func = NULL;
+  priv->pixbuf_data = NULL;
+  priv->pixbuf_destroy = NULL;
+}
+
 static void scale_image_destroy ( GtkWidget *self )
 {
   ScaleImagePrivate *priv;
@@ -47,6 +149,10 @@ static void scale_image_destroy ( GtkWidget *self )
   priv->file=NULL;
   g_free(priv->fname);
   priv->fname=NULL;
+  g_clear_pointer(&priv->key,g_free);
+  g_clear_pointer(&priv->base_key,g_free);
+  g_clear_pointer(&priv->base,cairo_surface_destroy);
+  scale_image_pixbuf_func_clear(priv);
   GTK_WIDGET_CLASS(scale_image_parent_class)->destroy(self);
 }
 
@@ -86,6 +192,7 @@ static void scale_image_get_size ( GtkWidget *self )
   priv = scale_image_get_instance_private(SCALE_IMAGE(self));
   
   gtk_image_clear(GTK_IMAGE(self));
+  g_clear_pointer(&priv->key,g_free);
   GTK_WIDGET_CLASS(scale_image_parent_class)->get_preferred_width(self,&m,
       &priv->raww);
   GTK_WIDGET_CLASS(scale_image_parent_class)->get_preferred_height(self,&m,
@@ -158,13 +265,46 @@ void scale_image_set_pixbuf ( GtkWidget *widget, GdkPixbuf *pb )
 {
   ScaleImagePrivate *priv = scale_image_get_instance_private(
       SCALE_IMAGE(widget));
+  scale_image_pixbuf_func_clear(priv);
   priv->pixbuf = pb;
   priv->ftype = SI_BUFF;
+  g_clear_pointer(&priv->key,g_free);
+  g_clear_pointer(&priv->base_key,g_free);
+  g_clear_pointer(&priv->base,cairo_surface_destroy);
+}
+
+/* set an image provider, func is called with the size required by the
+ * widget and returns a new pixbuf (preferably close to that size) */
+void scale_image_set_pixbuf_func ( GtkWidget *widget,
+    ScaleImagePixbufFunc func, gpointer data, GDestroyNotify destroy )
+{
+  ScaleImagePrivate *priv;
+
+  g_return_if_fail(IS_SCALE_IMAGE(widget));
+  priv = scale_image_get_instance_private(SCALE_IMAGE(widget));
+
+  if(priv->ftype == SI_BUFF && priv->pixbuf_func == func &&
+      priv->pixbuf_data == data)
+  {
+    if(destroy && data)
+      destroy(data);
+    return;
+  }
+
+  scale_image_pixbuf_func_clear(priv);
+  priv->pixbuf = NULL;
+  priv->pixbuf_func = func;
+  priv->pixbuf_data = data;
+  priv->pixbuf_destroy = destroy;
+  priv->ftype = SI_BUFF;
+  g_clear_pointer(&priv->file,g_free);
+  g_clear_pointer(&priv->key,g_free);
+  g_clear_pointer(&priv->base_key,g_free);
+  g_clear_pointer(&priv->base,cairo_surface_destroy);
 }
 
 static void scale_image_load_icon ( GtkWidget *self, gchar *icon )
 {
-  GdkPixbuf *buf;
   ScaleImagePrivate *priv;
 
   g_return_if_fail(IS_SCALE_IMAGE(self));
@@ -172,40 +312,112 @@ static void scale_image_load_icon ( GtkWidget *self, gchar *icon )
 
   if(!icon)
     return;
-  buf = gtk_icon_theme_load_icon(gtk_icon_theme_get_default(),icon,10,0,NULL);
-  if(buf)
+  if(gtk_icon_theme_has_icon(gtk_icon_theme_get_default(),icon))
   {
     g_free(priv->fname);
     priv->fname = icon;
     priv->ftype = SI_ICON;
-    g_object_unref(G_OBJECT(buf));
   }
   else
     g_free(icon);
 }
 
-static void scale_image_check_appinfo ( GtkWidget *self, gchar *icon )
+/* map of lowercase app_id candidates (desktop id, last component of a
+ * reverse dns id, StartupWMClass and executable name) to icon names, built
+ * from the installed desktop files and rebuilt when they change */
+static GHashTable *app_icon_map;
+static gboolean app_icon_map_valid;
+
+static void scale_image_app_map_changed ( GAppInfoMonitor *mon, gpointer d )
 {
-  ScaleImagePrivate *priv;
-  GDesktopAppInfo *app;
+  app_icon_map_valid = FALSE;
+}
 
-  g_return_if_fail(IS_SCALE_IMAGE(self));
-  app = g_desktop_app_info_new(icon);
-  if(!app)
+static void scale_image_app_map_add ( const gchar *key, const gchar *icon,
+    gboolean replace )
+{
+  gchar *lkey;
+
+  if(!key || !*key)
     return;
-  priv = scale_image_get_instance_private(SCALE_IMAGE(self));
 
-  if((!g_desktop_app_info_get_nodisplay(app))&&(priv->ftype==SI_NONE))
-    scale_image_load_icon(self,g_desktop_app_info_get_string(app,"Icon"));
-  g_object_unref(G_OBJECT(app));
+  lkey = g_ascii_strdown(key,-1);
+  if(!replace && g_hash_table_contains(app_icon_map,lkey))
+    g_free(lkey);
+  else
+    g_hash_table_insert(app_icon_map,lkey,g_strdup(icon));
+}
+
+static void scale_image_app_map_build ( void )
+{
+  GList *apps, *iter;
+  GDesktopAppInfo *app;
+  gchar *icon, *id, *exec, *ptr;
+
+  if(!app_icon_map)
+  {
+    app_icon_map = g_hash_table_new_full(g_str_hash,g_str_equal,g_free,
+        g_free);
+    g_signal_connect(G_OBJECT(g_app_info_monitor_get()),"changed",
+        G_CALLBACK(scale_image_app_map_changed),NULL);
+  }
+  else
+    g_hash_table_remove_all(app_icon_map);
+  app_icon_map_valid = TRUE;
+
+  apps = g_app_info_get_all();
+  for(iter=apps; iter; iter=g_list_next(iter))
+  {
+    if(!G_IS_DESKTOP_APP_INFO(iter->data))
+      continue;
+    app = iter->data;
+    if(g_desktop_app_info_get_nodisplay(app))
+      continue;
+    icon = g_desktop_app_info_get_string(app,"Icon");
+    if(!icon)
+      continue;
+
+    id = g_strdup(g_app_info_get_id(G_APP_INFO(app)));
+    if(id && g_str_has_suffix(id,".desktop"))
+      *(id+strlen(id)-8) = 0;
+    scale_image_app_map_add(id,icon,TRUE);
+    if(id && (ptr = strrchr(id,'.')) )
+      scale_image_app_map_add(ptr+1,icon,FALSE);
+    g_free(id);
+
+    scale_image_app_map_add(g_desktop_app_info_get_startup_wm_class(app),
+        icon,FALSE);
+
+    if(g_app_info_get_executable(G_APP_INFO(app)))
+    {
+      exec = g_path_get_basename(g_app_info_get_executable(G_APP_INFO(app)));
+      scale_image_app_map_add(exec,icon,FALSE);
+      g_free(exec);
+    }
+    g_free(icon);
+  }
+  g_list_free_full(apps,g_object_unref);
+}
+
+static const gchar *scale_image_app_icon ( const gchar *appid )
+{
+  const gchar *icon;
+  gchar *lappid;
+
+  if(!app_icon_map_valid)
+    scale_image_app_map_build();
+
+  lappid = g_ascii_strdown(appid,-1);
+  icon = g_hash_table_lookup(app_icon_map,lappid);
+  g_free(lappid);
+
+  return icon;
 }
 
 static void scale_image_check_icon ( GtkWidget *self, const gchar *file )
 {
-  gint i,j;
-  gchar *temp;
-  gchar ***desktop;
   ScaleImagePrivate *priv;
+  const gchar *icon;
 
   g_return_if_fail(IS_SCALE_IMAGE(self));
   priv = scale_image_get_instance_private(SCALE_IMAGE(self));
@@ -214,20 +426,9 @@ static void scale_image_check_icon ( GtkWidget *self, const gchar *file )
   if(priv->ftype!=SI_NONE)
     return;
 
-  desktop = g_desktop_app_info_search(file);
-  for(j=0;desktop[j];j++)
-  {
-    for(i=0;desktop[j][i];i++)
-      scale_image_check_appinfo(self,desktop[j][i]);
-    g_strfreev(desktop[j]);
-  }
-  g_free(desktop);
-  
-  if(priv->ftype!=SI_NONE)
-    return;
-  temp = g_strconcat(file,".desktop",NULL);
-  scale_image_check_appinfo(self,temp);
-  g_free(temp);
+  icon = scale_image_app_icon(file);
+  if(icon)
+    scale_image_load_icon(self,g_strdup(icon));
 }
 
 void scale_image_set_image ( GtkWidget *self, const gchar *image,
@@ -252,9 +453,13 @@ void scale_image_set_image ( GtkWidget *self, const gchar *image,
   g_free(priv->extra);
   priv->extra = g_strdup(extra);
   priv->ftype = SI_NONE;
+  g_clear_pointer(&priv->key,g_free);
 
+  /* inline svg images are cached by a checksum of their content */
   if(!g_ascii_strncasecmp(priv->file,"<?xml",5))
   {
+    g_free(priv->fname);
+    priv->fname = g_compute_checksum_for_string(G_CHECKSUM_MD5,priv->file,-1);
     priv->ftype = SI_DATA;
     return;
   }
@@ -291,38 +496,20 @@ void scale_image_set_image ( GtkWidget *self, const gchar *image,
   }
 }
 
-int scale_image_update ( GtkWidget *self )
+static cairo_surface_t *scale_image_render ( GtkWidget *self, gint size )
 {
   ScaleImagePrivate *priv;
   GtkIconTheme *theme;
   GdkPixbuf *buf = NULL, *tmp = NULL;
   GdkPixbufLoader *loader = NULL;
-  GdkRGBA *color = NULL;
   cairo_surface_t *cs;
-  cairo_t *cr;
   gchar *fallback;
-  gint w,h;
-  gint size;
 
-  g_return_val_if_fail(IS_SCALE_IMAGE(self),-1);
   priv = scale_image_get_instance_private(SCALE_IMAGE(self));
 
-  w = priv->w;
-  h = priv->h;
-  if(w<=2 || gtk_widget_get_hexpand(self))
-    w = MAX(w,priv->maxw);
-  if(h<=2 || gtk_widget_get_vexpand(self))
-    h = MAX(h,priv->maxh);
-  w *= gtk_widget_get_scale_factor(self);
-  h *= gtk_widget_get_scale_factor(self);
-  size = MIN(w,h);
-
   if(priv->file)
     g_debug("image: %s @ %d",priv->ftype==SI_DATA?"svg":priv->file,size);
 
-  if(size<1)
-    return -1;
-
   if(priv->ftype == SI_ICON && priv->fname)
   {
     theme = gtk_icon_theme_get_default();
@@ -341,6 +528,19 @@ int scale_image_update ( GtkWidget *self )
   else if(priv->ftype == SI_FILE && priv->fname)
     buf = gdk_pixbuf_new_from_file_at_scale(priv->fname,size,size,TRUE,NULL);
 
+  else if(priv->ftype == SI_BUFF && priv->pixbuf_func)
+  {
+    tmp = priv->pixbuf_func(priv->pixbuf_data,size);
+    if(tmp && gdk_pixbuf_get_width(tmp)==size &&
+        gdk_pixbuf_get_height(tmp)==size)
+      buf = tmp;
+    else if(tmp)
+    {
+      buf = gdk_pixbuf_scale_simple(tmp,size,size, GDK_INTERP_BILINEAR);
+      g_object_unref(G_OBJECT(tmp));
+    }
+  }
+
   else if(priv->ftype == SI_BUFF && priv->pixbuf)
     buf = gdk_pixbuf_scale_simple(priv->pixbuf,size,size, GDK_INTERP_BILINEAR);
 
@@ -351,7 +551,9 @@ int scale_image_update ( GtkWidget *self )
     gdk_pixbuf_loader_write(loader,(guchar *)priv->file,
         strlen(priv->file), NULL);
     gdk_pixbuf_loader_close(loader,NULL);
-    buf = gdk_pixbuf_copy(gdk_pixbuf_loader_get_pixbuf(loader));
+    buf = gdk_pixbuf_loader_get_pixbuf(loader);
+    if(buf)
+      g_object_ref(G_OBJECT(buf));
     g_object_unref(G_OBJECT(loader));
   }
 
@@ -366,27 +568,159 @@ int scale_image_update ( GtkWidget *self )
   }
 
   if(!buf)
-    return -1;
+    return NULL;
 
   cs = gdk_cairo_surface_create_from_pixbuf(buf,0,
       gtk_widget_get_window(self));
+  g_object_unref(G_OBJECT(buf));
+
+  return cs;
+}
+
+/* draw a color through the alpha channel of an image into a new surface,
+ * leaving the (possibly shared) source image intact */
+static cairo_surface_t *scale_image_recolor ( cairo_surface_t *base,
+    GdkRGBA *color, gint size )
+{
+  cairo_surface_t *cs;
+  cairo_t *cr;
+  gdouble sx, sy;
+
+  if(cairo_surface_get_type(base) == CAIRO_SURFACE_TYPE_IMAGE)
+    cs = cairo_surface_create_similar_image(base,CAIRO_FORMAT_ARGB32,
+        cairo_image_surface_get_width(base),
+        cairo_image_surface_get_height(base));
+  else
+    cs = cairo_surface_create_similar_image(base,CAIRO_FORMAT_ARGB32,
+        size,size);
+  cairo_surface_get_device_scale(base,&sx,&sy);
+  cairo_surface_set_device_scale(cs,sx,sy);
+
+  cr = cairo_create(cs);
+  cairo_set_source_rgba(cr,color->red,color->green,color->blue,color->alpha);
+  cairo_mask_surface(cr,base,0,0);
+  cairo_destroy(cr);
+
+  return cs;
+}
+
+static gsize scale_image_surface_size ( cairo_surface_t *cs, gint size )
+{
+  if(cairo_surface_get_type(cs) != CAIRO_SURFACE_TYPE_IMAGE)
+    return size * size * 4;
+  return cairo_image_surface_get_stride(cs) *
+    cairo_image_surface_get_height(cs);
+}
+
+int scale_image_update ( GtkWidget *self )
+{
+  ScaleImagePrivate *priv;
+  GdkRGBA *color = NULL;
+  cairo_surface_t *cs = NULL, *base = NULL;
+  gchar *key = NULL, *base_key = NULL, *rgba = NULL;
+  struct stat stattr;
+  gint w,h;
+  gint size, scale;
+
+  g_return_val_if_fail(IS_SCALE_IMAGE(self),-1);
+  priv = scale_image_get_instance_private(SCALE_IMAGE(self));
+
+  scale = gtk_widget_get_scale_factor(self);
+  w = priv->w;
+  h = priv->h;
+  if(w<=2 || gtk_widget_get_hexpand(self))
+    w = MAX(w,priv->maxw);
+  if(h<=2 || gtk_widget_get_vexpand(self))
+    h = MAX(h,priv->maxh);
+  w *= scale;
+  h *= scale;
+  size = MIN(w,h);
+
+  if(size<1)
+    return -1;
 
   gtk_widget_style_get(self,"color",&color,NULL);
   if(color)
+    rgba = gdk_rgba_to_string(color);
+
+  /* the uncolored image (base) is cached globally, except for pixbuf images
+   * whose base is kept by the widget. Recolored images are derived from the
+   * base and cached separately for each color. Image files can be rewritten
+   * in place, so their key includes the file's mtime and size */
+  if(priv->ftype == SI_BUFF && (priv->pixbuf || priv->pixbuf_data))
+    base_key = g_strdup_printf("%d:%p:%d:%d",priv->ftype,
+        priv->pixbuf_func?priv->pixbuf_data:priv->pixbuf,size,scale);
+  else if(priv->ftype == SI_FILE && priv->fname &&
+      !stat(priv->fname,&stattr))
+    base_key = g_strdup_printf("%d:%s:%ld.%09ld:%ld:%d:%d",priv->ftype,
+        priv->fname,(glong)stattr.st_mtim.tv_sec,(glong)stattr.st_mtim.tv_nsec,
+        (glong)stattr.st_size,size,scale);
+  else if(priv->ftype != SI_NONE && priv->fname)
+    base_key = g_strdup_printf("%d:%s:%d:%d",priv->ftype,priv->fname,size,
+        scale);
+  if(base_key)
+    key = g_strconcat(base_key,":",rgba?rgba:"",NULL);
+  g_free(rgba);
+
+  if(key && !g_strcmp0(key,priv->key))
+  {
+    g_free(key);
+    g_free(base_key);
+    gdk_rgba_free(color);
+    return 0;
+  }
+
+  if(priv->ftype == SI_BUFF)
+  {
+    if(priv->base && !g_strcmp0(priv->base_key,base_key))
+      base = cairo_surface_reference(priv->base);
+  }
+  else if( (base = scale_image_cache_lookup(base_key)) )
+    cairo_surface_reference(base);
+
+  if(color && priv->ftype != SI_BUFF &&
+      (cs = scale_image_cache_lookup(key)) )
+    cairo_surface_reference(cs);
+
+  if(!cs && !base && (base = scale_image_render(self,size)) )
   {
-    cr = cairo_create(cs);
-    cairo_set_source_rgba(cr,color->red,color->green,color->blue,color->alpha);
-    cairo_mask_surface(cr,cs,0,0);
-    cairo_destroy(cr);
+    if(priv->ftype == SI_BUFF)
+    {
+      g_clear_pointer(&priv->base,cairo_surface_destroy);
+      priv->base = cairo_surface_reference(base);
+      g_free(priv->base_key);
+      priv->base_key = g_strdup(base_key);
+    }
+    else
+      scale_image_cache_insert(base_key,base,scale_image_surface_size(base,size));
+  }
+
+  if(!cs && base)
+  {
+    if(color)
+    {
+      cs = scale_image_recolor(base,color,size);
+      if(priv->ftype != SI_BUFF)
+        scale_image_cache_insert(key,cs,scale_image_surface_size(cs,size));
+    }
+    else
+      cs = cairo_surface_reference(base);
   }
   gdk_rgba_free(color);
+  g_free(base_key);
+  if(base)
+    cairo_surface_destroy(base);
 
-  if(cs)
+  if(!cs)
   {
-    gtk_image_set_from_surface(GTK_IMAGE(self), cs);
-    cairo_surface_destroy(cs); 
+    g_free(key);
+    return -1;
   }
 
-  g_object_unref(G_OBJECT(buf));
+  gtk_image_set_from_surface(GTK_IMAGE(self), cs);
+  cairo_surface_destroy(cs);
+  g_free(priv->key);
+  priv->key = key;
+
   return 0;
 }
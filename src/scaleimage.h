@@ -23,6 +23,7 @@ struct _ScaleImageClass
 };
 
 typedef struct _ScaleImagePrivate ScaleImagePrivate;
+typedef GdkPixbuf *(*ScaleImagePixbufFunc) ( gpointer data, gint size );
 
 struct _ScaleImagePrivate
 {
@@ -33,7 +34,13 @@ struct _ScaleImagePrivate
   gchar *file;
   gchar *extra;
   gchar *fname;
+  gchar *key;
+  gchar *base_key;
+  cairo_surface_t *base;
   GdkPixbuf *pixbuf;
+  ScaleImagePixbufFunc pixbuf_func;
+  gpointer pixbuf_data;
+  GDestroyNotify pixbuf_destroy;
 };
 
 enum {
@@ -49,5 +56,9 @@ void scale_image_set_image ( GtkWidget *, const gchar *, gchar *);
 GtkWidget *scale_image_new();
 int scale_image_update ( GtkWidget *widget );
 void scale_image_set_pixbuf ( GtkWidget *widget, GdkPixbuf * );
+void scale_image_set_pixbuf_func ( GtkWidget *widget,
+    ScaleImagePixbufFunc func, gpointer data, GDestroyNotify destroy );
+void scale_image_cache_set_limit ( gsize limit );
+void scale_image_cache_clear ( void );
 
 #endif
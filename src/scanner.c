@@ -182,7 +182,10 @@ void scanner_update_json ( struct json_object *obj, ScanFile *file )
 }
 
 /* update variables in a specific file (or pipe) */
-int scanner_update_file ( GIOChannel *in, ScanFile *file )
+/* parse a channel into the variables of a file. If a hook is specified, it
+ * is called on each line read, before the variables are matched */
+int scanner_update_file_hook ( GIOChannel *in, ScanFile *file,
+    ScanLineFunc hook )
 {
   ScanVar *var;
   GList *node;
@@ -195,6 +198,8 @@ int scanner_update_file ( GIOChannel *in, ScanFile *file )
   while((status = g_io_channel_read_line(in,&read_buff,NULL,NULL,NULL))
       ==G_IO_STATUS_NORMAL)
   {
+    if(hook)
+      hook(read_buff);
     for(node=file->vars;node!=NULL;node=g_list_next(node))
     {
       var=node->data;
@@ -236,6 +241,11 @@ int scanner_update_file ( GIOChannel *in, ScanFile *file )
   return 0;
 }
 
+int scanner_update_file ( GIOChannel *in, ScanFile *file )
+{
+  return scanner_update_file_hook(in,file,NULL);
+}
+
 /* reset variables in a list */
 int scanner_reset_vars ( GList *var_list )
 {
@@ -40,10 +40,13 @@ typedef struct scan_var {
   ScanFile *file;
 } ScanVar;
 
+typedef void (*ScanLineFunc) ( const gchar *line );
+
 void scanner_expire ( void );
 int scanner_reset_vars ( GList * );
 void scanner_update_json ( struct json_object *, ScanFile * );
 int scanner_update_file ( GIOChannel *, ScanFile * );
+int scanner_update_file_hook ( GIOChannel *, ScanFile *, ScanLineFunc );
 int scanner_glob_file ( ScanFile * );
 char *scanner_get_string ( gchar *, gboolean );
 double scanner_get_numeric ( gchar *, gboolean );
@@ -14,6 +14,7 @@
 #include "switcher.h"
 #include "config.h"
 #include "sway_ipc.h"
+#include "scaleimage.h"
 
 gchar *confname;
 gchar *sockname;
@@ -22,6 +23,7 @@ static gchar *monitor;
 static gchar *dfilter;
 static GRegex *rfilter;
 static gboolean debug = FALSE;
+static gint icon_cache = -1;
 static enum ipc_type ipc;
 
 static GOptionEntry entries[] = {
@@ -32,6 +34,8 @@ static GOptionEntry entries[] = {
   {"debug-filter",'g',0,G_OPTION_ARG_STRING,&dfilter,"Filter debug output for a pattern"},
   {"monitor",'m',0,G_OPTION_ARG_STRING,&monitor,
     "Monitor to display the panel on (use \"-m list\" to list monitors`"},
+  {"icon-cache",'i',0,G_OPTION_ARG_INT,&icon_cache,
+    "Size of the icon cache in KiB"},
   {NULL}};
 
 void parse_command_line ( gint argc, gchar **argv)
@@ -96,15 +100,6 @@ void log_print ( const gchar *log_domain, GLogLevelFlags log_level,
   g_date_time_unref(now);
 }
 
-gboolean shell_timer ( gpointer data )
-{
-  taskbar_update_all();
-  switcher_update();
-  tray_update();
-
-  return TRUE;
-}
-
 static void activate (GtkApplication* app, gpointer data )
 {
   GdkDisplay *gdisp;
@@ -147,7 +142,6 @@ static void activate (GtkApplication* app, gpointer data )
 
   action_function_exec("SfwBarInit",NULL,NULL,NULL,NULL);
 
-  g_timeout_add (100,(GSourceFunc )shell_timer,NULL);
   g_unix_signal_add(SIGUSR1,(GSourceFunc)switcher_event,NULL);
   g_unix_signal_add(SIGUSR2,(GSourceFunc)bar_hide_event,"toggle");
 }
@@ -163,6 +157,8 @@ int main (int argc, gchar **argv)
 
   if(dfilter)
     rfilter = g_regex_new(dfilter,0,0,NULL);
+  if(icon_cache>=0)
+    scale_image_cache_set_limit(icon_cache*1024);
 
   app = gtk_application_new ("org.gtk.sfwbar", G_APPLICATION_NON_UNIQUE);
   g_signal_connect (app, "activate", G_CALLBACK (activate), NULL);
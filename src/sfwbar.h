@@ -12,6 +12,8 @@ enum ipc_type {
   IPC_WAYLAND = 3
 };
 
+typedef struct jscan JScan;
+
 void hypr_ipc_init ( void );
 enum ipc_type ipc_get ( void );
 void ipc_set ( enum ipc_type new );
@@ -27,12 +29,18 @@ void client_socket ( ScanFile *file );
 
 char *expr_parse ( gchar *expr_str, guint * );
 struct json_object *jpath_parse ( gchar *path, struct json_object *obj );
+JScan *jscan_parse ( const gchar *json, const gchar **keys );
+const gchar *jscan_get_string ( JScan *scan, const gchar *key );
+gint64 jscan_get_int ( JScan *scan, const gchar *key, gint64 defval );
+gboolean jscan_get_bool ( JScan *scan, const gchar *key, gboolean defval );
+void jscan_free ( JScan *scan );
 
 void widget_set_css ( GtkWidget *, gpointer );
 void widget_parse_css ( GtkWidget *widget, gchar *css );
 
 void mpd_ipc_init ( ScanFile *file );
 void mpd_ipc_command ( gchar *command );
+gdouble mpd_ipc_get_value ( const gchar *field );
 
 gint socket_connect ( const gchar *sockaddr, gint to );
 void list_remove_link ( GList **list, void *child );
@@ -49,12 +49,19 @@ typedef struct sni_item {
   gchar *path;
   gchar *string[SNI_MAX_STRING];
   gchar *menu_path;
-  GdkPixbuf *pixbuf[3];
+  GtkWidget *menu_cache;
+  GHashTable *menu_items;
+  guint32 menu_rev;
+  guint menu_signal;
+  GVariant *pixmap[3];
   gboolean menu;
   gboolean dirty;
   gint ref;
   guint signal;
   guint32 order;
+  guint32 pending;
+  guint timer;
+  gint64 last_fetch;
   GCancellable *cancel;
   GtkWidget *image;
   GtkWidget *box;
@@ -66,7 +73,9 @@ void sni_update ( void );
 GDBusConnection *sni_get_connection ( void );
 void sni_item_set_icon ( SniItem *sni, gint icon, gint pix );
 void sni_get_menu ( SniItem *sni, GdkEvent *event );
+void sni_menu_free ( SniItem *sni );
 SniItem *sni_item_new (GDBusConnection *, SniHost *, const gchar *);
 void sni_item_free ( SniItem *sni );
+void sni_item_set_refresh_interval ( gint64 interval );
 
 #endif
@@ -17,52 +17,89 @@ struct sni_prop_wrapper {
   SniItem *sni;
 };
 
+static gint64 sni_refresh_interval = 100000;
+
 static gchar *sni_properties[] = { "Category", "Id", "Title", "Status",
   "IconName", "OverlayIconName", "AttentionIconName", "AttentionMovieName",
   "XAyatanaLabel", "XAyatanaLabelGuide", "IconThemePath", "IconPixmap",
-  "OverlayIconPixmap", "AttentionIconPixmap", "ToolTip", "WindowId",
+  "OverlayIconPixmap", "AttentionIconPixmap", "WindowId", "ToolTip",
   "ItemIsMenu", "Menu", "XAyatanaOrderingIndex" };
 
-GdkPixbuf *sni_item_get_pixbuf ( GVariant *v )
+/* convert an (iiay) pixmap in network byte order ARGB32 into an RGBA
+ * pixbuf. The pixel data is read in place from the variant and converted
+ * in a single pass straight into the pixbuf buffer */
+static GdkPixbuf *sni_item_pixmap_decode ( GVariant *v )
 {
-  gint32 x,y;
-  GVariantIter *iter,*rgba;
-  guchar *buff;
-  guint32 *ptr;
-  guchar t;
-  cairo_surface_t *cs;
+  GVariant *data;
   GdkPixbuf *res;
-  gint i=0;
+  const guchar *src;
+  guchar *dst;
+  gint32 x, y;
+  gsize len, i, j;
+  gint stride;
 
-  if(!v)
+  g_variant_get_child(v,0,"i",&x);
+  g_variant_get_child(v,1,"i",&y);
+  if(x<=0 || y<=0)
     return NULL;
-  g_variant_get(v,"a(iiay)",&iter);
-  if(!iter || !g_variant_iter_n_children(iter))
-    return NULL;
-  g_variant_get(g_variant_iter_next_value(iter),"(iiay)",&x,&y,&rgba);
-  g_variant_iter_free(iter);
-  if(!rgba)
-    return NULL;
-  if(x*y != 0 && x*y*4 == g_variant_iter_n_children(rgba))
+
+  data = g_variant_get_child_value(v,2);
+  src = g_variant_get_fixed_array(data,&len,sizeof(guchar));
+  if(len != (gsize)x*y*4 ||
+      !(res = gdk_pixbuf_new(GDK_COLORSPACE_RGB,TRUE,8,x,y)))
   {
-    buff = g_malloc(x*y*4);
-    while(g_variant_iter_loop(rgba,"y",&t))
-      buff[i++]=t;
+    g_variant_unref(data);
+    return NULL;
+  }
+
+  dst = gdk_pixbuf_get_pixels(res);
+  stride = gdk_pixbuf_get_rowstride(res);
+  for(j=0; j<(gsize)y; j++)
+    for(i=0; i<(gsize)x*4; i+=4)
+    {
+      dst[j*stride+i] = src[j*x*4+i+1];
+      dst[j*stride+i+1] = src[j*x*4+i+2];
+      dst[j*stride+i+2] = src[j*x*4+i+3];
+      dst[j*stride+i+3] = src[j*x*4+i];
+    }
+  g_variant_unref(data);
+
+  return res;
+}
 
-    ptr=(guint32 *)buff;
-    for(i=0;i<x*y;i++)
-      ptr[i] = g_ntohl(ptr[i]);
+/* pick the smallest pixmap at least as large as the requested size, or the
+ * largest one if none are large enough, and decode only that one */
+static GdkPixbuf *sni_item_get_pixbuf ( GVariant *v, gint size )
+{
+  GVariant *pixmap;
+  GdkPixbuf *res;
+  gint32 x, y;
+  gint i, best = -1, bdim = 0, dim;
 
-    cs = cairo_image_surface_create_for_data(buff,CAIRO_FORMAT_ARGB32,x,y,
-        cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32,x));
-    res = gdk_pixbuf_get_from_surface(cs,0,0,x,y);
+  if(!v)
+    return NULL;
 
-    cairo_surface_destroy(cs);
-    g_free(buff);
+  for(i=0; i<g_variant_n_children(v); i++)
+  {
+    pixmap = g_variant_get_child_value(v,i);
+    g_variant_get_child(pixmap,0,"i",&x);
+    g_variant_get_child(pixmap,1,"i",&y);
+    g_variant_unref(pixmap);
+    dim = MAX(x,y);
+    if(best<0 || (dim>=size && (bdim<size || dim<bdim)) ||
+        (dim<size && bdim<size && dim>bdim))
+    {
+      best = i;
+      bdim = dim;
+    }
   }
-  else
-    res = NULL;
-  g_variant_iter_free(rgba);
+  if(best<0)
+    return NULL;
+
+  pixmap = g_variant_get_child_value(v,best);
+  res = sni_item_pixmap_decode(pixmap);
+  g_variant_unref(pixmap);
+
   return res;
 }
 
@@ -78,57 +115,86 @@ void sni_item_set_icon ( SniItem *sni, gint icon, gint pix )
     scale_image_set_image(sni->image,sni->string[icon],sni->string[SNI_PROP_THEME]);
     return;
   }
-  if(sni->pixbuf[pix-SNI_PROP_ICONPIX])
+  if(sni->pixmap[pix-SNI_PROP_ICONPIX])
   {
-    scale_image_set_pixbuf(sni->image,sni->pixbuf[pix-SNI_PROP_ICONPIX]);
+    scale_image_set_pixbuf_func(sni->image,
+        (ScaleImagePixbufFunc)sni_item_get_pixbuf,
+        g_variant_ref(sni->pixmap[pix-SNI_PROP_ICONPIX]),
+        (GDestroyNotify)g_variant_unref);
     return;
   }
   return;
 }
 
-void sni_item_prop_cb ( GDBusConnection *con, GAsyncResult *res,
-    struct sni_prop_wrapper *wrap)
+static void sni_item_set_prop ( SniItem *sni, guint prop, GVariant *inner )
 {
-  GVariant *result, *inner;
-
-  wrap->sni->ref--;
-  result = g_dbus_connection_call_finish(con, res, NULL);
-  if(result)
-    g_variant_get(result, "(v)",&inner);
-  if(!result || !inner)
-    return g_free(wrap);
-  g_variant_unref(result);
-
-  if(wrap->prop<=SNI_PROP_THEME &&
+  if(prop<=SNI_PROP_THEME &&
       g_variant_is_of_type(inner,G_VARIANT_TYPE_STRING))
   {
-    g_free(wrap->sni->string[wrap->prop]);
-    g_variant_get(inner,"s",&(wrap->sni->string[wrap->prop]));
-    g_debug("sni %s: property %s = %s",wrap->sni->dest,
-        sni_properties[wrap->prop],wrap->sni->string[wrap->prop]);
+    g_free(sni->string[prop]);
+    g_variant_get(inner,"s",&(sni->string[prop]));
+    g_debug("sni %s: property %s = %s",sni->dest,
+        sni_properties[prop],sni->string[prop]);
   }
-  else if((wrap->prop>=SNI_PROP_ICONPIX)&&(wrap->prop<=SNI_PROP_ATTNPIX))
+  else if((prop>=SNI_PROP_ICONPIX)&&(prop<=SNI_PROP_ATTNPIX))
   {
-    if(wrap->sni->pixbuf[wrap->prop-SNI_PROP_ICONPIX])
-      g_object_unref(wrap->sni->pixbuf[wrap->prop-SNI_PROP_ICONPIX]);
-    wrap->sni->pixbuf[wrap->prop-SNI_PROP_ICONPIX] =
-      sni_item_get_pixbuf(inner);
+    g_clear_pointer(&sni->pixmap[prop-SNI_PROP_ICONPIX],g_variant_unref);
+    if(g_variant_is_of_type(inner,G_VARIANT_TYPE("a(iiay)")) &&
+        g_variant_n_children(inner))
+      sni->pixmap[prop-SNI_PROP_ICONPIX] = g_variant_ref(inner);
   }
-  else if(wrap->prop == SNI_PROP_MENU &&
+  else if(prop == SNI_PROP_MENU &&
       g_variant_is_of_type(inner,G_VARIANT_TYPE_OBJECT_PATH))
     {
-      g_free(wrap->sni->menu_path);
-      g_variant_get(inner,"o",&(wrap->sni->menu_path));
-      g_debug("sni %s: property %s = %s",wrap->sni->dest,
-          sni_properties[wrap->prop],wrap->sni->menu_path);
+      sni_menu_free(sni);
+      g_free(sni->menu_path);
+      g_variant_get(inner,"o",&(sni->menu_path));
+      g_debug("sni %s: property %s = %s",sni->dest,
+          sni_properties[prop],sni->menu_path);
     }
-  else if(wrap->prop == SNI_PROP_ISMENU)
-    g_variant_get(inner,"b",&(wrap->sni->menu));
-  else if(wrap->prop == SNI_PROP_ORDER)
-    g_variant_get(inner,"u",&(wrap->sni->order));
+  else if(prop == SNI_PROP_ISMENU &&
+      g_variant_is_of_type(inner,G_VARIANT_TYPE_BOOLEAN))
+    g_variant_get(inner,"b",&(sni->menu));
+  else if(prop == SNI_PROP_ORDER &&
+      g_variant_is_of_type(inner,G_VARIANT_TYPE_UINT32))
+    g_variant_get(inner,"u",&(sni->order));
+}
+
+static void sni_item_request ( SniItem *sni, guint32 props );
+
+/* called once a property fetch completes (successfully or not) */
+static void sni_item_fetch_done ( SniItem *sni )
+{
+  if(sni->ref)
+    return;
+  tray_invalidate_all(sni);
+  if(sni->pending && !sni->timer)
+    sni_item_request(sni,0);
+}
+
+void sni_item_prop_cb ( GDBusConnection *con, GAsyncResult *res,
+    struct sni_prop_wrapper *wrap)
+{
+  GVariant *result, *inner;
+  GError *err = NULL;
+
+  result = g_dbus_connection_call_finish(con, res, &err);
+  if(g_error_matches(err,G_IO_ERROR,G_IO_ERROR_CANCELLED))
+  {
+    g_error_free(err);
+    return g_free(wrap);
+  }
+  g_clear_error(&err);
+  wrap->sni->ref--;
+  if(result)
+  {
+    g_variant_get(result, "(v)",&inner);
+    g_variant_unref(result);
+    sni_item_set_prop(wrap->sni,wrap->prop,inner);
+    g_variant_unref(inner);
+  }
 
-  g_variant_unref(inner);
-  tray_invalidate_all(wrap->sni);
+  sni_item_fetch_done(wrap->sni);
   g_free(wrap);
 }
 
@@ -149,36 +215,123 @@ void sni_item_get_prop ( GDBusConnection *con, SniItem *sni,
     (GAsyncReadyCallback)sni_item_prop_cb,wrap);
 }
 
+/* fetch all properties of an item with a single GetAll call, falling back
+ * to fetching properties one by one if the item doesn't support it */
+static void sni_item_get_all_cb ( GDBusConnection *con, GAsyncResult *res,
+    SniItem *sni )
+{
+  GVariant *result, *value;
+  GVariantIter *iter;
+  GError *err = NULL;
+  const gchar *name;
+  guint i;
+
+  result = g_dbus_connection_call_finish(con, res, &err);
+  if(g_error_matches(err,G_IO_ERROR,G_IO_ERROR_CANCELLED))
+  {
+    g_error_free(err);
+    return;
+  }
+  sni->ref--;
+  if(!result)
+  {
+    g_debug("sni %s: GetAll failed: %s",sni->dest,err?err->message:"");
+    g_clear_error(&err);
+    for(i=0;i<SNI_MAX_PROP;i++)
+      sni_item_get_prop(con,sni,i);
+    return;
+  }
+
+  g_variant_get(result,"(a{sv})",&iter);
+  while(g_variant_iter_next(iter,"{&sv}",&name,&value))
+  {
+    for(i=0;i<SNI_MAX_PROP;i++)
+      if(!g_strcmp0(name,sni_properties[i]))
+      {
+        sni_item_set_prop(sni,i,value);
+        break;
+      }
+    g_variant_unref(value);
+  }
+  g_variant_iter_free(iter);
+  g_variant_unref(result);
+  sni_item_fetch_done(sni);
+}
+
+static void sni_item_get_all ( GDBusConnection *con, SniItem *sni )
+{
+  sni->ref++;
+  g_dbus_connection_call(con, sni->dest, sni->path,
+    "org.freedesktop.DBus.Properties", "GetAll",
+    g_variant_new("(s)", sni->host->item_iface),G_VARIANT_TYPE("(a{sv})"),
+    G_DBUS_CALL_FLAGS_NONE,-1,sni->cancel,
+    (GAsyncReadyCallback)sni_item_get_all_cb,sni);
+}
+
+void sni_item_set_refresh_interval ( gint64 interval )
+{
+  sni_refresh_interval = MAX(interval,0) * 1000;
+}
+
+/* property refreshes requested by signals are accumulated per item. They
+ * are fetched at most once per refresh interval, with a trailing fetch for
+ * changes arriving in between and never while a fetch is in flight */
+static void sni_item_flush ( SniItem *sni )
+{
+  guint i;
+
+  for(i=0;i<SNI_MAX_PROP;i++)
+    if(sni->pending & (1<<i))
+      sni_item_get_prop(sni_get_connection(),sni,i);
+  sni->pending = 0;
+  sni->last_fetch = g_get_monotonic_time();
+}
+
+static gboolean sni_item_flush_cb ( SniItem *sni )
+{
+  sni->timer = 0;
+  if(!sni->ref)
+    sni_item_flush(sni);
+  return FALSE;
+}
+
+static void sni_item_request ( SniItem *sni, guint32 props )
+{
+  gint64 delay;
+
+  sni->pending |= props;
+  if(!sni->pending || sni->timer || sni->ref)
+    return;
+
+  delay = sni->last_fetch + sni_refresh_interval - g_get_monotonic_time();
+  if(delay<=0)
+    sni_item_flush(sni);
+  else
+    sni->timer = g_timeout_add(delay/1000+1,(GSourceFunc)sni_item_flush_cb,
+        sni);
+}
+
 void sni_item_signal_cb (GDBusConnection *con, const gchar *sender,
          const gchar *path, const gchar *interface, const gchar *signal,
          GVariant *parameters, gpointer data)
 {
   g_debug("sni: received signal %s from %s",signal,sender);
   if(!g_strcmp0(signal,"NewTitle"))
-    sni_item_get_prop(con,data,SNI_PROP_TITLE);
+    sni_item_request(data,1<<SNI_PROP_TITLE);
   else if(!g_strcmp0(signal,"NewStatus"))
-    sni_item_get_prop(con,data,SNI_PROP_STATUS);
+    sni_item_request(data,1<<SNI_PROP_STATUS);
   else if(!g_strcmp0(signal,"NewToolTip"))
-    sni_item_get_prop(con,data,SNI_PROP_TOOLTIP);
+    sni_item_request(data,1<<SNI_PROP_TOOLTIP);
   else if(!g_strcmp0(signal,"NewIconThemePath"))
-    sni_item_get_prop(con,data,SNI_PROP_THEME);
+    sni_item_request(data,1<<SNI_PROP_THEME);
   else if(!g_strcmp0(signal,"NewIcon"))
-  {
-    sni_item_get_prop(con,data,SNI_PROP_ICON);
-    sni_item_get_prop(con,data,SNI_PROP_ICONPIX);
-  }
+    sni_item_request(data,1<<SNI_PROP_ICON | 1<<SNI_PROP_ICONPIX);
   else if(!g_strcmp0(signal,"NewOverlayIcon"))
-  {
-    sni_item_get_prop(con,data,SNI_PROP_OVLAY);
-    sni_item_get_prop(con,data,SNI_PROP_OVLAYPIX);
-  }
+    sni_item_request(data,1<<SNI_PROP_OVLAY | 1<<SNI_PROP_OVLAYPIX);
   else if(!g_strcmp0(signal,"NewAttentionIcon"))
-  {
-    sni_item_get_prop(con,data,SNI_PROP_ATTN);
-    sni_item_get_prop(con,data,SNI_PROP_ATTNPIX);
-  }
+    sni_item_request(data,1<<SNI_PROP_ATTN | 1<<SNI_PROP_ATTNPIX);
   else if(!g_strcmp0(signal,"XAyatanaNewLabel"))
-    sni_item_get_prop(con,data,SNI_PROP_LABEL);
+    sni_item_request(data,1<<SNI_PROP_LABEL);
 }
 
 SniItem *sni_item_new (GDBusConnection *con, SniHost *host,
@@ -186,7 +339,6 @@ SniItem *sni_item_new (GDBusConnection *con, SniHost *host,
 {
   SniItem *sni;
   gchar *path;
-  guint i;
 
   sni = g_malloc0(sizeof(SniItem));
   sni->uid = g_strdup(uid);
@@ -206,8 +358,7 @@ SniItem *sni_item_new (GDBusConnection *con, SniHost *host,
   sni->signal = g_dbus_connection_signal_subscribe(con,sni->dest,
       sni->host->item_iface,NULL,sni->path,NULL,0,sni_item_signal_cb,sni,NULL);
   tray_item_init_for_all(sni);
-  for(i=0;i<SNI_MAX_PROP;i++)
-    sni_item_get_prop(con,sni,i);
+  sni_item_get_all(con,sni);
 
   return sni;
 }
@@ -221,9 +372,12 @@ void sni_item_free ( SniItem *sni )
   tray_item_destroy(sni);
   g_cancellable_cancel(sni->cancel);
   g_object_unref(sni->cancel);
+  if(sni->timer)
+    g_source_remove(sni->timer);
+  sni_menu_free(sni);
   for(i=0;i<3;i++)
-    if(sni->pixbuf[i]!=NULL)
-      g_object_unref(sni->pixbuf[i]);
+    if(sni->pixmap[i]!=NULL)
+      g_variant_unref(sni->pixmap[i]);
   for(i=0;i<SNI_MAX_STRING;i++)
     g_free(sni->string[i]);
 
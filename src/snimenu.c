@@ -13,8 +13,14 @@
 struct sni_menu_wrapper {
   GdkEvent *event;
   SniItem *sni;
+  gint32 parent;
 };
 
+/* menu layouts are cached per item together with the dbusmenu revision.
+ * LayoutUpdated signals refetch only the affected (sub)menu and
+ * ItemsPropertiesUpdated signals are applied to existing menu items */
+static void sni_menu_fetch ( SniItem *sni, gint32 parent, GdkEvent *event );
+
 gint32 sni_variant_get_int32 ( GVariant *dict, gchar *key, gint def )
 {
   GVariant *ptr;
@@ -151,6 +157,15 @@ void sni_menu_item_decorate ( GtkWidget *item, GVariant *dict  )
   gtk_container_add(GTK_CONTAINER(item),box);
 }
 
+static void sni_menu_item_destroy_cb ( GtkWidget *item, SniItem *sni )
+{
+  gint32 *id = g_object_get_data(G_OBJECT(item),"sni_id");
+
+  if(id && sni->menu_items &&
+      g_hash_table_lookup(sni->menu_items,GINT_TO_POINTER(*id))==item)
+    g_hash_table_remove(sni->menu_items,GINT_TO_POINTER(*id));
+}
+
 GtkWidget *sni_get_menu_iter ( GVariant *list, struct sni_menu_wrapper *wrap)
 {
   GVariantIter iter;
@@ -222,8 +237,16 @@ GtkWidget *sni_get_menu_iter ( GVariant *list, struct sni_menu_wrapper *wrap)
       *id = g_variant_get_int32(idv);
       g_variant_unref(idv);
       g_object_set_data_full(G_OBJECT(mitem),"sni_id",id,g_free);
+      g_object_set_data_full(G_OBJECT(mitem),"sni_props",g_variant_ref(dict),
+          (GDestroyNotify)g_variant_unref);
       g_signal_connect(G_OBJECT(mitem),"activate",
           G_CALLBACK(sni_menu_item_cb),wrap->sni);
+      g_signal_connect(G_OBJECT(mitem),"destroy",
+          G_CALLBACK(sni_menu_item_destroy_cb),wrap->sni);
+      if(!wrap->sni->menu_items)
+        wrap->sni->menu_items = g_hash_table_new(g_direct_hash,
+            g_direct_equal);
+      g_hash_table_insert(wrap->sni->menu_items,GINT_TO_POINTER(*id),mitem);
       gtk_container_add(GTK_CONTAINER(menu),mitem);
     }
 
@@ -235,19 +258,172 @@ GtkWidget *sni_get_menu_iter ( GVariant *list, struct sni_menu_wrapper *wrap)
   return menu;
 }
 
+static void sni_menu_invalidate ( SniItem *sni )
+{
+  if(!sni->menu_cache)
+    return;
+  gtk_widget_destroy(sni->menu_cache);
+  g_clear_object(&sni->menu_cache);
+}
+
+void sni_menu_free ( SniItem *sni )
+{
+  sni_menu_invalidate(sni);
+  g_clear_pointer(&sni->menu_items,g_hash_table_destroy);
+  if(sni->menu_signal)
+    g_dbus_connection_signal_unsubscribe(sni_get_connection(),
+        sni->menu_signal);
+  sni->menu_signal = 0;
+  sni->menu_rev = 0;
+}
+
+static gboolean sni_menu_key_is_structural ( const gchar *key )
+{
+  return !g_strcmp0(key,"visible") || !g_strcmp0(key,"type") ||
+    !g_strcmp0(key,"toggle-type") || !g_strcmp0(key,"children-display");
+}
+
+static void sni_menu_item_apply ( SniItem *sni, gint32 id, GVariant *props,
+    gchar **removed )
+{
+  GtkWidget *item;
+  GVariantBuilder builder;
+  GVariantIter iter;
+  GVariant *old, *dict, *value;
+  const gchar *key;
+
+  if(!sni->menu_items)
+    return;
+  item = g_hash_table_lookup(sni->menu_items,GINT_TO_POINTER(id));
+  if(!item)
+    return;
+
+  if(props)
+  {
+    g_variant_iter_init(&iter,props);
+    while(g_variant_iter_next(&iter,"{&sv}",&key,&value))
+    {
+      g_variant_unref(value);
+      if(sni_menu_key_is_structural(key))
+        return sni_menu_invalidate(sni);
+    }
+  }
+  if(removed && g_strv_contains((const gchar **)removed,"visible"))
+    return sni_menu_invalidate(sni);
+
+  g_variant_builder_init(&builder,G_VARIANT_TYPE_VARDICT);
+  old = g_object_get_data(G_OBJECT(item),"sni_props");
+  if(old)
+  {
+    g_variant_iter_init(&iter,old);
+    while(g_variant_iter_next(&iter,"{&sv}",&key,&value))
+    {
+      if((!props || !g_variant_lookup(props,key,"*",NULL)) &&
+          (!removed || !g_strv_contains((const gchar **)removed,key)))
+        g_variant_builder_add(&builder,"{sv}",key,value);
+      g_variant_unref(value);
+    }
+  }
+  if(props)
+  {
+    g_variant_iter_init(&iter,props);
+    while(g_variant_iter_next(&iter,"{&sv}",&key,&value))
+    {
+      g_variant_builder_add(&builder,"{sv}",key,value);
+      g_variant_unref(value);
+    }
+  }
+  dict = g_variant_ref_sink(g_variant_builder_end(&builder));
+  g_object_set_data_full(G_OBJECT(item),"sni_props",dict,
+      (GDestroyNotify)g_variant_unref);
+
+  sni_menu_item_decorate(item,dict);
+  gtk_widget_show_all(gtk_bin_get_child(GTK_BIN(item)));
+  gtk_widget_set_sensitive(item,sni_variant_get_bool(dict,"enabled",TRUE));
+  if(GTK_IS_CHECK_MENU_ITEM(item))
+  {
+    g_signal_handlers_block_by_func(G_OBJECT(item),
+        G_CALLBACK(sni_menu_item_cb),sni);
+    gtk_check_menu_item_set_active(GTK_CHECK_MENU_ITEM(item),
+        sni_variant_get_int32(dict,"toggle-state",0)==1);
+    g_signal_handlers_unblock_by_func(G_OBJECT(item),
+        G_CALLBACK(sni_menu_item_cb),sni);
+  }
+}
+
+static void sni_menu_signal_cb ( GDBusConnection *con, const gchar *sender,
+    const gchar *path, const gchar *interface, const gchar *signal,
+    GVariant *params, gpointer data )
+{
+  SniItem *sni = data;
+  GVariantIter *updated, *removed;
+  GVariant *props;
+  gchar **keys;
+  guint32 rev;
+  gint32 id;
+
+  g_debug("sni %s: menu signal %s",sni->dest,signal);
+  if(!g_strcmp0(signal,"LayoutUpdated") &&
+      g_variant_is_of_type(params,G_VARIANT_TYPE("(ui)")))
+  {
+    g_variant_get(params,"(ui)",&rev,&id);
+    if(!sni->menu_cache || (rev && rev==sni->menu_rev))
+      return;
+    if(!id)
+      sni_menu_invalidate(sni);
+    sni_menu_fetch(sni,id,NULL);
+  }
+  else if(!g_strcmp0(signal,"ItemsPropertiesUpdated") &&
+      g_variant_is_of_type(params,G_VARIANT_TYPE("(a(ia{sv})a(ias))")))
+  {
+    g_variant_get(params,"(a(ia{sv})a(ias))",&updated,&removed);
+    while(sni->menu_cache &&
+        g_variant_iter_next(updated,"(i@a{sv})",&id,&props))
+    {
+      sni_menu_item_apply(sni,id,props,NULL);
+      g_variant_unref(props);
+    }
+    while(sni->menu_cache && g_variant_iter_next(removed,"(i^as)",&id,&keys))
+    {
+      sni_menu_item_apply(sni,id,NULL,keys);
+      g_strfreev(keys);
+    }
+    g_variant_iter_free(updated);
+    g_variant_iter_free(removed);
+  }
+}
+
+static void sni_menu_popup ( SniItem *sni, GdkEvent *event )
+{
+  if(sni->menu_cache && event)
+    menu_popup(sni->image,sni->menu_cache,event,NULL,NULL);
+}
+
 void sni_get_menu_cb ( GObject *src, GAsyncResult *res, gpointer data )
 {
   GVariant *result, *layout, *list=NULL;
   struct sni_menu_wrapper *wrap = data;
-  GtkWidget *menu;
+  GtkWidget *menu, *item;
+  GError *err = NULL;
   gchar *tmp;
+  guint32 rev = 0;
 
-  result = g_dbus_connection_call_finish(G_DBUS_CONNECTION(src),res,NULL);
+  result = g_dbus_connection_call_finish(G_DBUS_CONNECTION(src),res,&err);
+  if(g_error_matches(err,G_IO_ERROR,G_IO_ERROR_CANCELLED))
+  {
+    g_error_free(err);
+    if(wrap->event)
+      gdk_event_free(wrap->event);
+    g_free(wrap);
+    return;
+  }
+  g_clear_error(&err);
   if(result)
   {
     tmp = g_variant_print(result,TRUE);
     g_debug("sni %s: menu: %s",wrap->sni->dest,tmp);
     g_free(tmp);
+    g_variant_get_child(result,0,"u",&rev);
     layout = g_variant_get_child_value(result, 1);
     if(layout)
     {
@@ -258,30 +434,60 @@ void sni_get_menu_cb ( GObject *src, GAsyncResult *res, gpointer data )
 
   menu = sni_get_menu_iter(list,wrap);
 
-  if(menu)
+  if(menu && wrap->parent && wrap->sni->menu_cache)
+  {
+    item = wrap->sni->menu_items ? g_hash_table_lookup(wrap->sni->menu_items,
+        GINT_TO_POINTER(wrap->parent)) : NULL;
+    if(item)
+      gtk_menu_item_set_submenu(GTK_MENU_ITEM(item),menu);
+    else
+    {
+      gtk_widget_destroy(menu);
+      sni_menu_invalidate(wrap->sni);
+    }
+    wrap->sni->menu_rev = rev;
+  }
+  else if(menu)
   {
-    g_object_ref_sink(G_OBJECT(menu));
-    g_signal_connect(G_OBJECT(menu),"unmap",G_CALLBACK(g_object_unref),NULL);
-    menu_popup(wrap->sni->image,menu,wrap->event,NULL,NULL);
+    sni_menu_invalidate(wrap->sni);
+    wrap->sni->menu_cache = g_object_ref_sink(G_OBJECT(menu));
+    wrap->sni->menu_rev = rev;
   }
 
-  gdk_event_free(wrap->event);
+  sni_menu_popup(wrap->sni,wrap->event);
+
+  if(wrap->event)
+    gdk_event_free(wrap->event);
   g_free(wrap);
   if(result)
     g_variant_unref(result);
 }
 
-void sni_get_menu ( SniItem *sni, GdkEvent *event )
+static void sni_menu_fetch ( SniItem *sni, gint32 parent, GdkEvent *event )
 {
   struct sni_menu_wrapper *wrap = g_malloc(sizeof(struct sni_menu_wrapper));
 
-  wrap->event = gdk_event_copy(event);
+  wrap->event = event?gdk_event_copy(event):NULL;
   wrap->sni = sni;
+  wrap->parent = parent;
 
-  g_debug("sni %s: requesting menu",wrap->sni->dest);
+  g_debug("sni %s: requesting menu (parent %d)",wrap->sni->dest,parent);
+
+  if(!sni->menu_signal)
+    sni->menu_signal = g_dbus_connection_signal_subscribe(
+        sni_get_connection(),sni->dest,"com.canonical.dbusmenu",NULL,
+        sni->menu_path,NULL,0,sni_menu_signal_cb,sni,NULL);
 
   g_dbus_connection_call(sni_get_connection(), sni->dest, sni->menu_path,
       "com.canonical.dbusmenu", "GetLayout",
-      g_variant_new("(iias)", 0, -1, NULL),
-      NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL, sni_get_menu_cb, wrap);
+      g_variant_new("(iias)", parent, -1, NULL),
+      NULL, G_DBUS_CALL_FLAGS_NONE, -1, sni->cancel, sni_get_menu_cb, wrap);
+}
+
+void sni_get_menu ( SniItem *sni, GdkEvent *event )
+{
+  if(sni->menu_cache)
+    sni_menu_popup(sni,event);
+  else
+    sni_menu_fetch(sni,0,event);
 }
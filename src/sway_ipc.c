@@ -16,17 +16,34 @@
 #include "wintree.h"
 
 static gchar *bar_id;
-static gint main_ipc;
+static gint main_ipc = -1;
 static const  gint8 magic[6] = {0x69, 0x33, 0x2d, 0x69, 0x70, 0x63};
 static ScanFile *sway_file;
+static gchar *focus_ws, *focus_output;
+static gpointer focus_ws_id;
+static guint resync_timer;
+
+#define SWAY_RESYNC_DELAY 250
 
 extern gchar *sockname;
 
-static json_object *sway_ipc_poll ( gint sock, gint32 *etype )
+#define SWAY_IPC_MAX_PAYLOAD 16777216
+
+typedef void (*SwayIpcCallback) ( struct json_object *, gpointer );
+
+struct sway_ipc_req {
+  SwayIpcCallback cb;
+  gpointer data;
+};
+
+static gint req_ipc = -1;
+static guint req_watch;
+static GQueue req_queue = G_QUEUE_INIT;
+
+static gchar *sway_ipc_read ( gint sock, gint32 *etype )
 {
   gint8 sway_ipc_header[14];
   gchar *response = NULL;
-  json_object *res;
   guint32 plen;
   size_t pos=0;
   ssize_t rlen;
@@ -44,7 +61,7 @@ static json_object *sway_ipc_poll ( gint sock, gint32 *etype )
     pos=0;
     memcpy(etype,sway_ipc_header+sizeof(magic)+sizeof(plen),sizeof(plen));
     memcpy(&plen,sway_ipc_header+sizeof(magic),sizeof(plen));
-    if(plen>65536)
+    if(plen>SWAY_IPC_MAX_PAYLOAD)
       response=NULL;
     else
       response = g_malloc(plen+1);
@@ -66,11 +83,7 @@ static json_object *sway_ipc_poll ( gint sock, gint32 *etype )
         response[plen]='\0';
     }
   }
-  if(!response)
-    return NULL;
-  res = json_tokener_parse(response);
-  g_free(response);
-  return res;
+  return response;
 }
 
 static int sway_ipc_open (int to)
@@ -90,13 +103,16 @@ static int sway_ipc_send ( gint sock, gint32 type, gchar *command )
 {
   gint8 sway_ipc_header[14];
   gint32 plen = strlen(command);
+
+  if(sock<0)
+    return -1;
   memcpy(sway_ipc_header,magic,sizeof(magic));
   memcpy(sway_ipc_header+sizeof(magic),&plen,sizeof(plen));
   memcpy(sway_ipc_header+sizeof(magic)+sizeof(plen),&type,sizeof(type));
-  if( write(sock,sway_ipc_header,sizeof(sway_ipc_header))==-1 )
+  if( send(sock,sway_ipc_header,sizeof(sway_ipc_header),MSG_NOSIGNAL)==-1 )
     return -1;
   if(plen>0)
-    if( write(sock,command,plen)==-1 )
+    if( send(sock,command,plen,MSG_NOSIGNAL)==-1 )
       return -1;
   return 0;
 }
@@ -116,19 +132,122 @@ void sway_ipc_command ( gchar *cmd, ... )
   va_end(args);
 }
 
-static json_object *sway_ipc_request ( gchar *command, gint32 type, gint32 *etype )
+/* drop the request connection, pending requests complete with no reply */
+static void sway_ipc_req_close ( void )
+{
+  struct sway_ipc_req *req;
+  GQueue pending;
+
+  if(req_watch)
+    g_source_remove(req_watch);
+  req_watch = 0;
+  if(req_ipc>=0)
+    close(req_ipc);
+  req_ipc = -1;
+
+  pending = req_queue;
+  g_queue_init(&req_queue);
+  while( (req = g_queue_pop_head(&pending)) )
+  {
+    if(req->cb)
+      req->cb(NULL,req->data);
+    g_free(req);
+  }
+}
+
+/* sway replies to requests in order, so the head of the queue owns
+ * the next reply on the connection */
+static gboolean sway_ipc_req_dispatch ( void )
+{
+  struct sway_ipc_req *req;
+  struct json_object *json;
+  gchar *response;
+  gint32 etype;
+
+  response = sway_ipc_read(req_ipc,&etype);
+  if(!response)
+  {
+    sway_ipc_req_close();
+    return FALSE;
+  }
+
+  req = g_queue_pop_head(&req_queue);
+  if(req && req->cb)
+  {
+    json = json_tokener_parse(response);
+    req->cb(json,req->data);
+    json_object_put(json);
+  }
+  g_free(req);
+  g_free(response);
+  return TRUE;
+}
+
+static gboolean sway_ipc_req_event ( GIOChannel *chan, GIOCondition cond,
+    gpointer data )
+{
+  gchar c;
+
+  while(req_ipc>=0 && recv(req_ipc,&c,1,MSG_PEEK | MSG_DONTWAIT)>0)
+    if(!sway_ipc_req_dispatch())
+      return FALSE;
+
+  if(req_ipc<0)
+    return FALSE;
+
+  if(cond & (G_IO_HUP | G_IO_ERR))
+  {
+    req_watch = 0;
+    sway_ipc_req_close();
+    return FALSE;
+  }
+  return TRUE;
+}
+
+static gboolean sway_ipc_req_open ( void )
 {
-  gint sock;
-  json_object *json;
+  GIOChannel *chan;
+
+  if(req_ipc>=0)
+    return TRUE;
+
+  req_ipc = sway_ipc_open(3000);
+  if(req_ipc<0)
+    return FALSE;
 
-  sock = sway_ipc_open(3000);
-  if(sock==-1)
-    return NULL;
-  sway_ipc_send(sock,type,command);
-  json = sway_ipc_poll(sock,etype);
-  close(sock);
+  chan = g_io_channel_unix_new(req_ipc);
+  req_watch = g_io_add_watch(chan,G_IO_IN | G_IO_HUP | G_IO_ERR,
+      sway_ipc_req_event,NULL);
+  g_io_channel_unref(chan);
+  return TRUE;
+}
+
+/* queue a request on the persistent request connection, the callback is
+ * invoked with the reply (or NULL if the connection was lost). The
+ * connection is (re)established on demand, so a restarted sway is picked
+ * up on the next request */
+static gboolean sway_ipc_request_async ( gchar *command, gint32 type,
+    SwayIpcCallback cb, gpointer data )
+{
+  struct sway_ipc_req *req;
+
+  if(sway_ipc_send(req_ipc,type,command)==-1)
+  {
+    sway_ipc_req_close();
+    if(!sway_ipc_req_open() || sway_ipc_send(req_ipc,type,command)==-1)
+    {
+      sway_ipc_req_close();
+      if(cb)
+        cb(NULL,data);
+      return FALSE;
+    }
+  }
 
-  return json;
+  req = g_malloc0(sizeof(struct sway_ipc_req));
+  req->cb = cb;
+  req->data = data;
+  g_queue_push_tail(&req_queue,req);
+  return TRUE;
 }
 
 static GdkRectangle sway_ipc_parse_rect ( struct json_object *obj )
@@ -145,43 +264,58 @@ static GdkRectangle sway_ipc_parse_rect ( struct json_object *obj )
   return ret;
 }
 
-static void sway_minimized_set ( struct json_object *obj, const gchar *parent,
-    const gchar *monitor )
+static gboolean sway_window_set_location ( window_t *win,
+    const gchar *parent, const gchar *monitor )
 {
-  window_t *win;
-
-  win = wintree_from_id(
-      GINT_TO_POINTER(json_int_by_name(obj,"id",G_MININT64)));
-
-  if(!win)
-    return;
+  gboolean change = FALSE;
 
   if(!g_strcmp0(parent,"__i3_scratch"))
+  {
+    change = !(win->state & WS_MINIMIZED);
     win->state |= WS_MINIMIZED;
+  }
   else
   {
+    change = !!(win->state & WS_MINIMIZED);
     win->state &= ~WS_MINIMIZED;
-    g_free(win->workspace);
-    win->workspace = g_strdup(parent);
+    if(parent && g_strcmp0(win->workspace,parent))
+    {
+      g_free(win->workspace);
+      win->workspace = g_strdup(parent);
+      change = TRUE;
+    }
   }
 
-  if(g_strcmp0(monitor,win->output) && g_strcmp0(monitor,"__i3"))
+  if(monitor && g_strcmp0(monitor,win->output) && g_strcmp0(monitor,"__i3"))
   {
     g_free(win->output);
     win->output = g_strdup(monitor);
-    wintree_commit(win);
+    change = TRUE;
   }
+
+  return change;
 }
 
-static void sway_set_state ( struct json_object *container)
+static void sway_minimized_set ( struct json_object *obj, const gchar *parent,
+    const gchar *monitor )
 {
   window_t *win;
 
   win = wintree_from_id(
-      GINT_TO_POINTER(json_int_by_name(container,"id",G_MININT64)));
+      GINT_TO_POINTER(json_int_by_name(obj,"id",G_MININT64)));
+
+  if(win && sway_window_set_location(win,parent,monitor))
+    wintree_commit(win);
+}
+
+static void sway_set_state ( gpointer wid, gint64 fullscreen_mode )
+{
+  window_t *win;
+
+  win = wintree_from_id(wid);
   if(win)
   {
-    if(json_int_by_name(container,"fullscreen_mode",0))
+    if(fullscreen_mode)
       win->state |= WS_FULLSCREEN | WS_MAXIMIZED;
     else
       win->state &= ~ (WS_FULLSCREEN | WS_MAXIMIZED);
@@ -216,29 +350,22 @@ static struct json_object *placement_find_wid ( struct json_object *obj, gint64
   return ret;
 }
 
-static void sway_ipc_window_place ( gint64 wid, gint64 pid )
+static void sway_ipc_window_place_cb ( struct json_object *json,
+    gpointer data )
 {
-  gint32 etype;
-  struct json_object *json;
   GdkRectangle output, win, *obs;
   struct json_object *obj,*ptr,*item,*arr;
+  gint64 wid = *(gint64 *)data;
   gint c,i,nobs;
 
-  if(!wintree_placer_check(pid))
-    return;
-
-  json = sway_ipc_request("",4,&etype);
-
+  g_free(data);
   if(!json)
     return;
 
   obj = placement_find_wid ( json, wid );
   if(!obj || !json_object_object_get_ex(obj,"floating_nodes",&arr) ||
       !json_object_is_type(arr,json_type_array))
-  {
-    json_object_put(json);
     return;
-  }
   output = sway_ipc_parse_rect(obj);
   win = output;
   nobs = json_object_array_length(arr)-1;
@@ -263,42 +390,56 @@ static void sway_ipc_window_place ( gint64 wid, gint64 pid )
         wid,win.x,win.y);
   }
   g_free(obs);
-  json_object_put(json);
 }
 
-static void sway_window_new ( struct json_object *container )
+static void sway_ipc_window_place ( gint64 wid, gint64 pid )
 {
-  struct json_object *ptr;
-  gpointer wid;
-  window_t *win;
-  const gchar *app_id;
+  gint64 *data;
 
-  wid = GINT_TO_POINTER(json_int_by_name(container,"id",G_MININT64));
-  if(wintree_from_id(GINT_TO_POINTER(wid)))
+  if(!wintree_placer_check(pid))
     return;
-  
-  app_id = json_string_by_name(container,"app_id");
-  if(!app_id)
-  {
-    json_object_object_get_ex(container,"window_properties",&ptr);
-    if(ptr)
-      app_id = json_string_by_name(ptr,"instance");
-  }
-  if(!app_id)
+
+  data = g_new(gint64,1);
+  *data = wid;
+  sway_ipc_request_async("",4,sway_ipc_window_place_cb,data);
+}
+
+static void sway_window_new ( gpointer wid, gint64 pid, const gchar *app_id,
+    const gchar *title, gboolean focused )
+{
+  window_t *win;
+
+  if(!app_id || wintree_from_id(wid))
     return;
 
   win = wintree_window_init();
   win->uid = wid;
-  win->pid = json_int_by_name(container,"pid",G_MININT64);
+  win->pid = pid;
   wintree_window_append(win);
   wintree_set_app_id(wid,app_id);
-  wintree_set_title(wid,json_string_by_name(container,"name"));
+  wintree_set_title(wid,title);
   wintree_log(wid);
 
-  if(json_bool_by_name(container,"focused",FALSE))
+  if(focused)
     wintree_set_focus(wid);
 
-  sway_ipc_window_place(GPOINTER_TO_INT(wid), win->pid );
+  sway_ipc_window_place((glong)wid, win->pid );
+}
+
+static void sway_window_new_json ( struct json_object *container )
+{
+  struct json_object *ptr;
+  const gchar *app_id;
+
+  app_id = json_string_by_name(container,"app_id");
+  if(!app_id && json_object_object_get_ex(container,"window_properties",&ptr))
+    app_id = json_string_by_name(ptr,"instance");
+
+  sway_window_new(
+      GINT_TO_POINTER(json_int_by_name(container,"id",G_MININT64)),
+      json_int_by_name(container,"pid",G_MININT64), app_id,
+      json_string_by_name(container,"name"),
+      json_bool_by_name(container,"focused",FALSE));
 }
 
 static void sway_traverse_tree ( struct json_object *obj, const gchar *parent,
@@ -313,7 +454,7 @@ static void sway_traverse_tree ( struct json_object *obj, const gchar *parent,
     {
       iter = json_object_array_get_idx(arr,i);
       if(init)
-        sway_window_new (iter);
+        sway_window_new_json (iter);
       sway_minimized_set(iter,parent,monitor);
     }
 
@@ -325,7 +466,7 @@ static void sway_traverse_tree ( struct json_object *obj, const gchar *parent,
       if( json_int_by_name(iter,"app_id",G_MININT64) != G_MININT64 )
       {
         if(init)
-          sway_window_new (iter);
+          sway_window_new_json (iter);
         sway_minimized_set(iter,parent,monitor);
       }
       else
@@ -346,6 +487,61 @@ static void sway_traverse_tree ( struct json_object *obj, const gchar *parent,
     }
 }
 
+static void sway_ipc_resync_cb ( struct json_object *json, gpointer data )
+{
+  if(json)
+    sway_traverse_tree(json,NULL,NULL,FALSE);
+}
+
+static gboolean sway_ipc_resync ( gpointer data )
+{
+  resync_timer = 0;
+  sway_ipc_request_async("",4,sway_ipc_resync_cb,NULL);
+  return FALSE;
+}
+
+/* window events don't carry the destination of a move, so fall back on
+ * a (debounced) full tree walk to pick it up */
+static void sway_ipc_resync_schedule ( void )
+{
+  if(!resync_timer)
+    resync_timer = g_timeout_add(SWAY_RESYNC_DELAY,sway_ipc_resync,NULL);
+}
+
+static void sway_ipc_focus_set ( const gchar *name, const gchar *output,
+    gpointer id )
+{
+  focus_ws_id = id;
+  if(g_strcmp0(focus_ws,name))
+  {
+    g_free(focus_ws);
+    focus_ws = g_strdup(name);
+  }
+  if(output && g_strcmp0(focus_output,output))
+  {
+    g_free(focus_output);
+    focus_output = g_strdup(output);
+  }
+}
+
+/* a window receiving focus is shown on the focused workspace, so its
+ * location can be updated from the workspace model without a tree walk */
+static void sway_ipc_window_focus ( gpointer wid )
+{
+  window_t *win;
+  gboolean change = FALSE;
+
+  win = wintree_from_id(wid);
+  if(!win)
+    return;
+  if(focus_ws)
+    change = sway_window_set_location(win,focus_ws,focus_output);
+  if(!wintree_is_focused(wid))
+    wintree_set_focus(wid);
+  else if(change)
+    wintree_commit(win);
+}
+
 void sway_ipc_client_init ( ScanFile *file )
 {
   sway_file = file;
@@ -364,51 +560,141 @@ workspace_t *sway_ipc_parse_workspace ( json_object *obj )
   return ws;
 }
 
-static void sway_ipc_pager_event ( struct json_object *obj )
+static void sway_ipc_pager_event ( const gchar *payload )
 {
+  static const gchar *keys[] = { "change", "current.id", "current.name",
+    "current.visible", "current.focused", "current.output", NULL };
   const gchar *change;
-  struct json_object *current;
-  workspace_t *ws;
+  workspace_t ws;
+  JScan *scan;
 
-  json_object_object_get_ex(obj,"current",&current);
-  if(!current)
-    return;
+  scan = jscan_parse(payload,keys);
+  if(!jscan_get_string(scan,"current.id"))
+    return jscan_free(scan);
 
-  ws = sway_ipc_parse_workspace(current);
-  change = json_string_by_name(obj,"change");
+  memset(&ws,0,sizeof(workspace_t));
+  ws.id = GINT_TO_POINTER(jscan_get_int(scan,"current.id",0));
+  ws.name = (gchar *)jscan_get_string(scan,"current.name");
+  ws.visible = jscan_get_bool(scan,"current.visible",FALSE);
+  ws.focused = jscan_get_bool(scan,"current.focused",FALSE);
+  change = jscan_get_string(scan,"change");
 
   if(!g_strcmp0(change,"empty"))
-    pager_workspace_delete(ws->id);
+    pager_workspace_delete(ws.id);
   else
-    pager_workspace_new(ws);
+    pager_workspace_new(&ws);
 
   if(!g_strcmp0(change,"focus"))
-    pager_workspace_set_focus(ws->id);
+  {
+    pager_workspace_set_focus(ws.id);
+    sway_ipc_focus_set(ws.name,jscan_get_string(scan,"current.output"),ws.id);
+  }
+  else if(ws.id == focus_ws_id && (!g_strcmp0(change,"rename") ||
+        !g_strcmp0(change,"move")))
+    sway_ipc_focus_set(ws.name,jscan_get_string(scan,"current.output"),ws.id);
 
   pager_update();
-  g_free(ws->name);
-  g_free(ws);
+  jscan_free(scan);
 }
 
-static void sway_ipc_pager_populate ( void )
+static void sway_ipc_window_event ( const gchar *payload )
+{
+  static const gchar *keys[] = { "change", "container.id", "container.pid",
+    "container.name", "container.app_id",
+    "container.window_properties.instance", "container.focused",
+    "container.fullscreen_mode", NULL };
+  const gchar *change, *app_id;
+  gpointer wid;
+  JScan *scan;
+
+  scan = jscan_parse(payload,keys);
+  change = jscan_get_string(scan,"change");
+  wid = GINT_TO_POINTER(jscan_get_int(scan,"container.id",G_MININT64));
+
+  if(!g_strcmp0(change,"new"))
+  {
+    app_id = jscan_get_string(scan,"container.app_id");
+    if(!app_id)
+      app_id = jscan_get_string(scan,"container.window_properties.instance");
+    sway_window_new(wid,jscan_get_int(scan,"container.pid",G_MININT64),
+        app_id,jscan_get_string(scan,"container.name"),
+        jscan_get_bool(scan,"container.focused",FALSE));
+  }
+  else if(!g_strcmp0(change,"close"))
+    wintree_window_delete(wid);
+  else if(!g_strcmp0(change,"title"))
+    wintree_set_title(wid,jscan_get_string(scan,"container.name"));
+  else if(!g_strcmp0(change,"focus"))
+    sway_ipc_window_focus(wid);
+  else if(!g_strcmp0(change,"fullscreen_mode"))
+    sway_set_state(wid,jscan_get_int(scan,"container.fullscreen_mode",0));
+  else if(!g_strcmp0(change,"move"))
+    sway_ipc_resync_schedule();
+
+  /* title, mark and urgency changes don't affect pager previews */
+  if(!g_strcmp0(change,"new") || !g_strcmp0(change,"close") ||
+      !g_strcmp0(change,"move") || !g_strcmp0(change,"floating") ||
+      !g_strcmp0(change,"fullscreen_mode") || !g_strcmp0(change,"focus"))
+    pager_geom_invalidate();
+
+  jscan_free(scan);
+}
+
+static void sway_ipc_barconfig_event ( const gchar *payload )
+{
+  static const gchar *keys[] = { "id", "mode", "hidden_state", NULL };
+  JScan *scan;
+
+  scan = jscan_parse(payload,keys);
+  if ( !bar_id || !g_strcmp0(jscan_get_string(scan,"id"),bar_id) )
+  {
+    bar_hide_event(jscan_get_string(scan,"mode"));
+    if(g_strcmp0(jscan_get_string(scan,"hidden_state"),"hide"))
+    {
+      sway_ipc_command("bar %s hidden_state hide",
+          jscan_get_string(scan,"id"));
+      switcher_event(NULL);
+    }
+  }
+  jscan_free(scan);
+}
+
+static void sway_ipc_bar_state_event ( const gchar *payload )
+{
+  static const gchar *keys[] = { "id", "visible_by_modifier", NULL };
+  JScan *scan;
+
+  scan = jscan_parse(payload,keys);
+  if ( !bar_id || !g_strcmp0(jscan_get_string(scan,"id"),bar_id) )
+    bar_hide_event(jscan_get_bool(scan,"visible_by_modifier",FALSE)?
+        "visible":NULL);
+  jscan_free(scan);
+}
+
+static void sway_ipc_pager_populate_cb ( struct json_object *robj,
+    gpointer data )
 {
-  gint32 etype;
-  struct json_object *robj;
   gint i;
   workspace_t *ws;
 
-  robj = sway_ipc_request("",1,&etype);
-
   if(!robj || !json_object_is_type(robj,json_type_array))
     return;
   for(i=0;i<json_object_array_length(robj);i++)
   {
     ws = sway_ipc_parse_workspace(json_object_array_get_idx(robj,i));
     pager_workspace_new(ws);
+    if(ws->focused)
+      sway_ipc_focus_set(ws->name,json_string_by_name(
+            json_object_array_get_idx(robj,i),"output"),ws->id);
     g_free(ws->name);
     g_free(ws);
   }
-  json_object_put(robj);
+  pager_update();
+}
+
+static void sway_ipc_pager_populate ( void )
+{
+  sway_ipc_request_async("",1,sway_ipc_pager_populate_cb,NULL);
 }
 
 static gboolean sway_ipc_event ( GIOChannel *chan, GIOCondition cond,
@@ -426,78 +712,40 @@ static gboolean sway_ipc_event ( GIOChannel *chan, GIOCondition cond,
     "","","","","","","","","","","","","",
     "bar_state_update",
     "input" };
-  struct json_object *obj,*container;
-  struct json_object *scan;
-  const gchar *change;
+  struct json_object *obj, *scan;
+  gchar *payload;
   gint32 etype;
-  gpointer *wid;
 
   if(main_ipc==-1)
     return FALSE;
 
-  obj = sway_ipc_poll(main_ipc,&etype);
-  while (obj)
+  while( (payload = sway_ipc_read(main_ipc,&etype)) )
   { 
     if(etype==0x80000000)
-      sway_ipc_pager_event(obj);
+      sway_ipc_pager_event(payload);
+    else if(etype==0x80000003)
+      sway_ipc_window_event(payload);
+    else if(etype==0x80000004)
+      sway_ipc_barconfig_event(payload);
+    else if(etype==0x80000014)
+      sway_ipc_bar_state_event(payload);
 
-    if(etype==0x80000004)
-      if ( !bar_id || !g_strcmp0(json_string_by_name(obj,"id"),bar_id) )
-      {
-        bar_hide_event(json_string_by_name(obj,"mode"));
-        if(g_strcmp0(json_string_by_name(obj,"hidden_state"),"hide"))
-        {
-          sway_ipc_command("bar %s hidden_state hide",
-              json_string_by_name(obj,"id"));
-          switcher_event(NULL);
-        }
-      }
-    if(etype==0x00000004) // This is to capture minimized state on sway
-      sway_traverse_tree(obj,NULL,NULL,FALSE);
-
-    if(etype==0x80000003 && obj)
-    {
-      change = json_string_by_name(obj,"change");
-      if(change)
-      {
-        json_object_object_get_ex(obj,"container",&container);
-        wid = GINT_TO_POINTER(json_int_by_name(container,"id",G_MININT64));
-
-        if(!g_strcmp0(change,"new"))
-          sway_window_new (container);
-        else if(!g_strcmp0(change,"close"))
-          wintree_window_delete(wid);
-        else if(!g_strcmp0(change,"title"))
-          wintree_set_title(wid,json_string_by_name(container,"name"));
-        else if(!g_strcmp0(change,"focus"))
-        {
-          wintree_set_focus(wid);
-          sway_ipc_send(main_ipc,4,"");
-        }
-        else if(!g_strcmp0(change,"fullscreen_mode"))
-          sway_set_state(container);
-        else if(!g_strcmp0(change,"move"))
-          sway_ipc_send(main_ipc,4,"");
-      }
-    }
-
-    if(etype==0x80000014)
-      if ( !bar_id || !g_strcmp0(json_string_by_name(obj,"id"),bar_id) )
-        bar_hide_event(json_bool_by_name(obj,"visible_by_modifier",FALSE)?"visible":NULL);
+    if(etype==0x80000000)
+      pager_geom_invalidate();
 
-    if(sway_file && etype>=0x80000000 && etype<=0x80000015)
+    /* only build a json object tree if a SwayClient needs it */
+    if(sway_file && etype>=0x80000000 && etype<=0x80000015 &&
+        (obj = json_tokener_parse(payload)) )
     {
       scan = json_object_new_object();
       json_object_object_add_ex(scan,ename[etype-0x80000000],obj,0);
       scanner_reset_vars(sway_file->vars);
       scanner_update_json (scan,sway_file);
-      json_object_get(obj);
       json_object_put(scan);
       base_widget_emit_trigger("sway");
     }
 
-    json_object_put(obj);
-    obj = sway_ipc_poll(main_ipc,&etype);
+    g_free(payload);
   }
   return TRUE;
 }
@@ -561,71 +809,58 @@ static struct wintree_api sway_wintree_api = {
   .free_workspace = g_free
 };
 
-static guint sway_ipc_get_geom ( workspace_t *ws, GdkRectangle **wins,
-    GdkRectangle *space, gint *focus )
+static void sway_ipc_geom_cb ( struct json_object *obj, gpointer data )
 {
-  gint32 etype;
-  struct json_object *obj = NULL;
   struct json_object *iter,*fiter,*arr;
-  gint i,j,n = 0;
+  GdkRectangle space, *wins;
+  gint i,j,n,focus;
 
-  obj = sway_ipc_request("",1,&etype);
+  if(!obj || !json_object_is_type(obj,json_type_array))
+    return;
 
-  *wins = NULL;
-  *focus = -1;
-  if(obj && json_object_is_type(obj,json_type_array))
-    for(i=0;i<json_object_array_length(obj);i++)
+  for(i=0;i<json_object_array_length(obj);i++)
+  {
+    iter = json_object_array_get_idx(obj,i);
+    space = sway_ipc_parse_rect(iter);
+    wins = NULL;
+    focus = -1;
+    n = 0;
+    if(json_object_object_get_ex(iter,"floating_nodes",&arr) &&
+        json_object_is_type(arr,json_type_array))
     {
-      iter = json_object_array_get_idx(obj,i);
-      if(!g_strcmp0(ws->name,json_string_by_name(iter,"name")))
+      n = json_object_array_length(arr);
+      wins = g_malloc0(n * sizeof(GdkRectangle));
+      for(j=0;j<n;j++)
       {
-        *space = sway_ipc_parse_rect(iter);
-        json_object_object_get_ex(iter,"floating_nodes",&arr);
-        if(arr && json_object_is_type(arr,json_type_array))
-        {
-          n = json_object_array_length(arr);
-          *wins = g_malloc0(n * sizeof(GdkRectangle));
-          for(j=0;j<n;j++)
-          {
-            fiter = json_object_array_get_idx(arr,j);
-            (*wins)[j] = sway_ipc_parse_rect(fiter);
-            if(json_bool_by_name(fiter,"focused",FALSE))
-              *focus = j;
-          }
-        }
+        fiter = json_object_array_get_idx(arr,j);
+        wins[j] = sway_ipc_parse_rect(fiter);
+        if(json_bool_by_name(fiter,"focused",FALSE))
+          focus = j;
       }
     }
+    pager_workspace_set_geom(GINT_TO_POINTER(json_int_by_name(iter,"id",0)),
+        &space,wins,n,focus);
+  }
+}
 
-  json_object_put(obj);
-  return n;
+static void sway_ipc_update_geom ( void )
+{
+  sway_ipc_request_async("",1,sway_ipc_geom_cb,NULL);
 }
 
 static struct pager_api sway_pager_api = {
   .set_workspace = sway_ipc_set_workspace,
-  .get_geom = sway_ipc_get_geom
+  .update_geom = sway_ipc_update_geom
 };
 
-void sway_ipc_init ( void )
+/* the initial window list is requested asynchronously and events are
+ * subscribed to once it is in, so no window event predates the snapshot */
+static void sway_ipc_init_cb ( struct json_object *obj, gpointer data )
 {
-  struct json_object *obj;
-  gint sock;
-  gint32 etype;
+  GIOChannel *chan;
 
-  sock=sway_ipc_open(3000);
-  if(sock==-1)
-    return;
-  ipc_set(IPC_SWAY);
-  sway_ipc_send(sock,0,"bar hidden_state hide");
-  obj = sway_ipc_poll(sock,&etype);
-  json_object_put(obj);
-  sway_ipc_send(sock,4,"");
-  obj = sway_ipc_poll(sock,&etype);
-  close(sock);
   if(obj)
-  {
     sway_traverse_tree(obj,NULL,NULL,TRUE);
-    json_object_put(obj);
-  }
 
   main_ipc = sway_ipc_open(10);
   if(main_ipc<0)
@@ -634,10 +869,19 @@ void sway_ipc_init ( void )
   sway_ipc_send(main_ipc, 2, "['workspace','mode','window',\
       'barconfig_update','binding','shutdown','tick',\
       'bar_state_update','input']");
-  GIOChannel *chan = g_io_channel_unix_new(main_ipc);
+  chan = g_io_channel_unix_new(main_ipc);
   g_io_add_watch(chan,G_IO_IN,sway_ipc_event,NULL);
 
   sway_ipc_pager_populate();
+}
+
+void sway_ipc_init ( void )
+{
+  if(!sway_ipc_req_open())
+    return;
+  ipc_set(IPC_SWAY);
+  sway_ipc_request_async("bar hidden_state hide",0,NULL,NULL);
+  sway_ipc_request_async("",4,sway_ipc_init_cb,NULL);
 
   wintree_api_register(&sway_wintree_api);
   pager_api_register(&sway_pager_api);
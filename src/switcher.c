@@ -18,6 +18,7 @@ static GtkWidget *grid;
 static gint interval;
 static gchar hstate;
 static gint counter;
+static guint timer;
 static gint title_width = -1;
 static GList *focus;
 
@@ -87,6 +88,31 @@ void switcher_populate ( void )
     switcher_window_init(iter->data);
 }
 
+static gboolean switcher_timer ( gpointer data )
+{
+  window_t *win;
+
+  if(!switcher || counter <= 0)
+  {
+    timer = 0;
+    return FALSE;
+  }
+  counter--;
+
+  if(counter > 0)
+  {
+    flow_grid_update(grid);
+    css_widget_cascade(switcher,NULL);
+    return TRUE;
+  }
+
+  gtk_widget_hide(switcher);
+  win = focus->data;
+  wintree_focus(win->uid);
+  timer = 0;
+  return FALSE;
+}
+
 gboolean switcher_event ( gpointer data )
 {
   GList *item;
@@ -100,6 +126,8 @@ gboolean switcher_event ( gpointer data )
     focus=wintree_get_list();
   if(focus!=NULL)
     wintree_set_focus(((window_t *)focus->data)->uid);
+  if(!timer && counter > 0)
+    timer = g_timeout_add(100,(GSourceFunc)switcher_timer,NULL);
 
   return TRUE;
 }
@@ -119,29 +147,6 @@ void switcher_window_init ( window_t *win)
   flow_grid_add_child(grid,switcher_item_new(win,grid));
 }
 
-void switcher_update ( void )
-{
-  window_t *win;
-
-  if(!switcher)
-    return;
-
-  if(counter <= 0)
-    return;
-  counter--;
-
-  if(counter > 0)
-  {
-    flow_grid_update(grid);
-    css_widget_cascade(switcher,NULL);
-  }
-  else
-  {
-    gtk_widget_hide(switcher);
-    win = focus->data;
-    wintree_focus(win->uid);
-  }
-}
 
 void switcher_invalidate ( window_t *win )
 {
@@ -36,7 +36,6 @@ void switcher_window_delete ( window_t *win );
 GtkWidget *switcher_new();
 gboolean switcher_event ( gpointer );
 void switcher_invalidate ( window_t *win );
-void switcher_update ( void );
 void switcher_window_init ( window_t *win);
 void switcher_populate ( void );
 
@@ -147,6 +147,6 @@ void switcher_item_invalidate ( GtkWidget *self )
   g_return_if_fail(IS_SWITCHER_ITEM(self));
   priv = switcher_item_get_instance_private(SWITCHER_ITEM(self));
 
-  flow_grid_invalidate(priv->switcher);
+  flow_grid_invalidate_item(priv->switcher,self);
   priv->invalid = TRUE;
 }
@@ -151,10 +151,3 @@ void taskbar_destroy_item ( window_t *win )
     }
 }
 
-void taskbar_update_all ( void )
-{
-  GList *iter;
-
-  for(iter=taskbars; iter; iter=g_list_next(iter))
-    flow_grid_update(iter->data);
-}
@@ -158,7 +158,8 @@ static void taskbar_group_class_init ( TaskbarGroupClass *kclass )
 {
   GTK_WIDGET_CLASS(kclass)->destroy = taskbar_group_destroy;
   FLOW_ITEM_CLASS(kclass)->update = taskbar_group_update;
-  FLOW_ITEM_CLASS(kclass)->comp_parent = (GCompareFunc)g_strcmp0;
+  FLOW_ITEM_CLASS(kclass)->parent_hash = g_str_hash;
+  FLOW_ITEM_CLASS(kclass)->parent_equal = g_str_equal;
   FLOW_ITEM_CLASS(kclass)->get_parent = 
     (void * (*)(GtkWidget *))taskbar_group_get_appid;
   FLOW_ITEM_CLASS(kclass)->compare = taskbar_group_compare;
@@ -288,7 +289,7 @@ void taskbar_group_invalidate ( GtkWidget *self )
   g_return_if_fail(IS_TASKBAR_GROUP(self));
   priv = taskbar_group_get_instance_private(TASKBAR_GROUP(self));
 
-  flow_grid_invalidate(priv->taskbar);
+  flow_grid_invalidate_item(priv->taskbar,self);
   priv->invalid = TRUE;
 }
 
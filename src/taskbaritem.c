@@ -114,6 +114,19 @@ static window_t *taskbar_item_get_window ( GtkWidget *self )
   return priv->win;
 }
 
+static void taskbar_item_check_active ( GtkWidget *self )
+{
+  TaskbarItemPrivate *priv;
+
+  g_return_if_fail(IS_TASKBAR_ITEM(self));
+  priv = taskbar_item_get_instance_private(TASKBAR_ITEM(self));
+
+  flow_item_set_active(self, !priv->win->output ||
+      !g_object_get_data(G_OBJECT(priv->taskbar),"filter_output") ||
+      !g_strcmp0(priv->win->output,
+        bar_get_output(base_widget_get_child(priv->taskbar))));
+}
+
 static void taskbar_item_update ( GtkWidget *self )
 {
   TaskbarItemPrivate *priv;
@@ -145,10 +158,7 @@ static void taskbar_item_update ( GtkWidget *self )
   gtk_widget_unset_state_flags(gtk_bin_get_child(GTK_BIN(self)),
       GTK_STATE_FLAG_PRELIGHT);
 
-  flow_item_set_active(self, !priv->win->output ||
-      !g_object_get_data(G_OBJECT(priv->taskbar),"filter_output") ||
-      !g_strcmp0(priv->win->output,
-        bar_get_output(base_widget_get_child(priv->taskbar))));
+  taskbar_item_check_active(self);
 
   priv->invalid = FALSE;
 }
@@ -170,6 +180,7 @@ static void taskbar_item_class_init ( TaskbarItemClass *kclass )
   GTK_WIDGET_CLASS(kclass)->destroy = taskbar_item_destroy;
   FLOW_ITEM_CLASS(kclass)->update = taskbar_item_update;
   FLOW_ITEM_CLASS(kclass)->invalidate = taskbar_item_invalidate;
+  FLOW_ITEM_CLASS(kclass)->check_active = taskbar_item_check_active;
   FLOW_ITEM_CLASS(kclass)->get_parent = (void * (*)(GtkWidget *))taskbar_item_get_window;
   FLOW_ITEM_CLASS(kclass)->compare = taskbar_item_compare;
 }
@@ -260,6 +271,6 @@ void taskbar_item_invalidate ( GtkWidget *self )
   g_return_if_fail(IS_TASKBAR_ITEM(self));
   priv = taskbar_item_get_instance_private(TASKBAR_ITEM(self));
 
-  flow_grid_invalidate(priv->taskbar);
+  flow_grid_invalidate_item(priv->taskbar,self);
   priv->invalid = TRUE;
 }
@@ -75,11 +75,3 @@ void tray_item_destroy ( SniItem *sni )
     flow_grid_delete_child(iter->data,sni);
 }
 
-void tray_update ( void )
-{
-  GList *iter;
-
-  for(iter=trays; iter; iter=g_list_next(iter))
-    if(iter->data)
-      flow_grid_update(iter->data);
-}
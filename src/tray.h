@@ -36,7 +36,6 @@ GType tray_get_type ( void );
 GtkWidget *tray_new();
 void tray_item_init_for_all ( SniItem *sni );
 void tray_item_destroy ( SniItem *sni );
-void tray_update ( void );
 void tray_invalidate_all ( SniItem *sni );
 
 #endif
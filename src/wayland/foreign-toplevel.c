@@ -24,65 +24,114 @@ void foreign_toplevel_activate ( gpointer tl )
         gdk_display_get_default_seat(gdk_display_get_default())));
 }
 
+/* the protocol sends changes in groups terminated by a done event, we
+ * buffer them per handle and apply them to the window tree in one go */
+struct toplevel_pending {
+  gchar *title;
+  gchar *app_id;
+  guint16 state;
+  gboolean state_set;
+};
+
 static void toplevel_handle_app_id(void *data, wlr_fth *tl, const gchar *appid)
 {
-  wintree_set_app_id(tl,appid);
+  struct toplevel_pending *pending = data;
+
+  g_free(pending->app_id);
+  pending->app_id = g_strdup(appid);
 }
 
 static void toplevel_handle_title(void *data, wlr_fth *tl, const gchar *title)
 {
-  wintree_set_title(tl,title);
+  struct toplevel_pending *pending = data;
+
+  g_free(pending->title);
+  pending->title = g_strdup(title);
 }
 
 static void toplevel_handle_closed(void *data, wlr_fth *tl)
 {
+  struct toplevel_pending *pending = data;
+
   wintree_window_delete(tl);
   zwlr_foreign_toplevel_handle_v1_destroy(tl);
-}
-
-static void toplevel_handle_done(void *data, wlr_fth *tl)
-{
-  wintree_log(tl);
+  g_free(pending->app_id);
+  g_free(pending->title);
+  g_free(pending);
 }
 
 static void toplevel_handle_state(void *data, wlr_fth *tl,
                 struct wl_array *state)
 {
+  struct toplevel_pending *pending = data;
   uint32_t *entry;
-  window_t *win;
-
-  win = wintree_from_id(tl);
-  if(!win)
-    return;
 
-  win->state = 0;
+  pending->state = 0;
+  pending->state_set = TRUE;
 
   wl_array_for_each(entry, state)
     switch(*entry)
     {
     case ZWLR_FOREIGN_TOPLEVEL_HANDLE_V1_STATE_MINIMIZED:
-      win->state |= WS_MINIMIZED;
+      pending->state |= WS_MINIMIZED;
       break;
     case ZWLR_FOREIGN_TOPLEVEL_HANDLE_V1_STATE_MAXIMIZED:
-      win->state |= WS_MAXIMIZED;
+      pending->state |= WS_MAXIMIZED;
       break;
     case ZWLR_FOREIGN_TOPLEVEL_HANDLE_V1_STATE_FULLSCREEN:
-      win->state |= WS_FULLSCREEN;
+      pending->state |= WS_FULLSCREEN;
       break;
     case ZWLR_FOREIGN_TOPLEVEL_HANDLE_V1_STATE_ACTIVATED:
-      win->state |= WS_FOCUSED;
-      wintree_set_focus(win->uid);
+      pending->state |= WS_FOCUSED;
       break;
     }
+}
+
+static void toplevel_handle_done(void *data, wlr_fth *tl)
+{
+  struct toplevel_pending *pending = data;
+  window_t *win;
+  gboolean change;
+
+  win = wintree_from_id(tl);
+  if(!win)
+    return;
+
+  change = wintree_update_app_id(win,pending->app_id);
+  change |= wintree_update_title(win,pending->title);
+
+  if(pending->state_set)
+  {
+    change |= (win->state != pending->state);
+    win->state = pending->state;
+
+    /* a focus change commits both the old and the new focused window */
+    if((win->state & WS_FOCUSED) && !wintree_is_focused(tl))
+    {
+      wintree_set_focus(tl);
+      change = FALSE;
+    }
+    else if(!(win->state & WS_FOCUSED) && wintree_is_focused(tl))
+    {
+      wintree_set_focus(NULL);
+      change = FALSE;
+    }
+
+    g_debug("foreign toplevel state for %p: %s%s%s%s", win->uid,
+      win->state & WS_FOCUSED ? "Activated, " : "",
+      win->state & WS_MINIMIZED ? "Minimized, " : "",
+      win->state & WS_MAXIMIZED ? "Maximized, " : "",
+      win->state & WS_FULLSCREEN ? "Fullscreen" : ""
+      );
+  }
 
-  if(wintree_is_focused(win->uid) && !(win->state & WS_FOCUSED))
-    wintree_set_focus(NULL);
-  g_debug("foreign toplevel state for %p: %s%s%s%s", win->uid,
-    win->state & WS_FOCUSED ? "Activated, " : "",
-    win->state & WS_MINIMIZED ? "Minimized, " : "",
-    win->state & WS_MAXIMIZED ? "Maximized, " : "",
-    win->state & WS_FULLSCREEN ? "Fullscreen" : ""
-    );
+  if(change)
+    wintree_commit(win);
+
+  g_clear_pointer(&pending->app_id,g_free);
+  g_clear_pointer(&pending->title,g_free);
+  pending->state_set = FALSE;
+  wintree_log(tl);
 }
 
 static void toplevel_handle_parent(void *data, wlr_fth *tl, wlr_fth *pt)
@@ -119,7 +168,8 @@ static void toplevel_manager_handle_toplevel(void *data,
   win->uid = tl;
   wintree_window_append(win);
 
-  zwlr_foreign_toplevel_handle_v1_add_listener(tl, &toplevel_impl, NULL);
+  zwlr_foreign_toplevel_handle_v1_add_listener(tl, &toplevel_impl,
+      g_malloc0(sizeof(struct toplevel_pending)));
 }
 
 static void toplevel_manager_handle_finished(void *data,
@@ -11,10 +11,12 @@
 
 static struct wintree_api api;
 static GList *wt_list;
+static GHashTable *wt_uid, *wt_pid;
 static GList *appid_map;
 static gpointer wt_focus;
 static gchar *wt_active;
 static guint64 seq;
+static gint64 title_interval = 100000;
 
 struct appid_mapper{
   GRegex *regex;
@@ -99,24 +101,52 @@ gboolean wintree_is_focused ( gpointer id )
 
 window_t *wintree_from_id ( gpointer id )
 {
-  GList *item;
-  for(item = wt_list; item; item = g_list_next(item) )
-    if ( ((window_t *)(item->data))->uid == id )
-      break;
-  if(!item)
+  if(!wt_uid)
     return NULL;
-  return item->data;
+  return g_hash_table_lookup(wt_uid,id);
 }
 
-window_t *wintree_from_pid ( gint64 pid )
+static void wintree_index_add ( window_t *win )
 {
-  GList *item;
-  for(item = wt_list; item; item = g_list_next(item) )
-    if ( ((window_t *)(item->data))->pid == pid )
-      break;
-  if(!item)
-    return NULL;
-  return item->data;
+  GList *list;
+
+  if(!wt_uid)
+  {
+    wt_uid = g_hash_table_new(g_direct_hash,g_direct_equal);
+    wt_pid = g_hash_table_new_full(g_int64_hash,g_int64_equal,g_free,NULL);
+  }
+  g_hash_table_insert(wt_uid,win->uid,win);
+  list = g_hash_table_lookup(wt_pid,&win->pid);
+  g_hash_table_insert(wt_pid,g_memdup(&win->pid,sizeof(gint64)),
+      g_list_prepend(list,win));
+}
+
+static void wintree_index_remove ( window_t *win )
+{
+  GList *list;
+
+  g_hash_table_remove(wt_uid,win->uid);
+  list = g_list_remove(g_hash_table_lookup(wt_pid,&win->pid),win);
+  if(list)
+    g_hash_table_insert(wt_pid,g_memdup(&win->pid,sizeof(gint64)),list);
+  else
+    g_hash_table_remove(wt_pid,&win->pid);
+}
+
+/* the pid may only be known after the window was added */
+void wintree_set_pid ( window_t *win, gint64 pid )
+{
+  if(!win || win->pid==pid)
+    return;
+
+  if(wintree_from_id(win->uid)!=win)
+  {
+    win->pid = pid;
+    return;
+  }
+  wintree_index_remove(win);
+  win->pid = pid;
+  wintree_index_add(win);
 }
 
 void wintree_commit ( window_t *win )
@@ -125,41 +155,92 @@ void wintree_commit ( window_t *win )
   switcher_invalidate(win);
 }
 
-void wintree_set_title ( gpointer wid, const gchar *title )
+void wintree_set_title_interval ( gint interval )
 {
-  window_t *win;
-
-  if(!title)
-    return;
+  title_interval = MAX(0,interval) * 1000;
+}
 
-  win = wintree_from_id(wid);
-  if(!win)
-    return;
-  if(!g_strcmp0(win->title,title))
-    return;
+static gboolean wintree_title_apply ( window_t *win )
+{
+  if(!win->title_pending)
+    return FALSE;
 
   g_free(win->title);
-  win->title = g_strdup(title);
+  win->title = g_steal_pointer(&win->title_pending);
+  win->title_time = g_get_monotonic_time();
   wintree_set_active(win->title);
-  wintree_commit(win);
+  return TRUE;
 }
 
-void wintree_set_app_id ( gpointer wid, const gchar *app_id)
+static gboolean wintree_title_commit ( window_t *win )
 {
-  window_t *win;
+  win->title_timer = 0;
+  if(wintree_title_apply(win))
+    wintree_commit(win);
+  return FALSE;
+}
 
-  if(!app_id)
-    return;
+/* title changes are propagated at most once per title_interval, a
+ * trailing update ensures the last title is always shown. Until then the
+ * new title is held in title_pending, so readers and sort functions see
+ * the title of the last commit. Returns TRUE if the title was applied
+ * right away and the window needs to be committed by the caller */
+gboolean wintree_update_title ( window_t *win, const gchar *title )
+{
+  gint64 elapsed;
+
+  if(!win || !title)
+    return FALSE;
+  if(!g_strcmp0(win->title_pending?win->title_pending:win->title,title))
+    return FALSE;
+
+  g_free(win->title_pending);
+  win->title_pending = g_strdup(title);
+
+  if(win->title_timer)
+    return FALSE;
+
+  elapsed = g_get_monotonic_time() - win->title_time;
+  if(elapsed >= title_interval)
+    return wintree_title_apply(win);
+
+  win->title_timer = g_timeout_add((title_interval-elapsed)/1000 + 1,
+      (GSourceFunc)wintree_title_commit,win);
+  return FALSE;
+}
+
+void wintree_set_title ( gpointer wid, const gchar *title )
+{
+  window_t *win;
 
   win = wintree_from_id(wid);
-  if(!win)
-    return;
+  if(wintree_update_title(win,title))
+    wintree_commit(win);
+}
+
+/* set the app_id of a window, moving its taskbar item to a new group if
+ * needed. Returns TRUE if the app_id changed and the window needs to be
+ * committed by the caller */
+gboolean wintree_update_app_id ( window_t *win, const gchar *app_id )
+{
+  if(!win || !app_id || !g_strcmp0(win->appid,app_id))
+    return FALSE;
+
   taskbar_reparent_item(win,app_id);
   g_free(win->appid);
   win->appid = g_strdup(app_id);
   if(!win->title)
     win->title = g_strdup(app_id);
-  wintree_commit(win);
+  return TRUE;
+}
+
+void wintree_set_app_id ( gpointer wid, const gchar *app_id)
+{
+  window_t *win;
+
+  win = wintree_from_id(wid);
+  if(wintree_update_app_id(win,app_id))
+    wintree_commit(win);
 }
 
 void wintree_window_append ( window_t *win )
@@ -178,31 +259,32 @@ void wintree_window_append ( window_t *win )
   }
   if( !win->switcher && (win->title || win->appid) )
     switcher_window_init(win);
-  if(g_list_find(wt_list,win)==NULL)
+  if(wintree_from_id(win->uid)!=win)
+  {
     wt_list = g_list_append (wt_list,win);
+    wintree_index_add(win);
+  }
   wintree_commit(win);
 }
 
 void wintree_window_delete ( gpointer id )
 {
-  GList *item;
   window_t *win;
 
-  for(item = wt_list; item; item = g_list_next(item) )
-    if ( ((window_t *)(item->data))->uid == id )
-      break;
-  if(!item)
-    return;
-  win = item->data;
+  win = wintree_from_id(id);
   if(!win)
     return;
+  if(win->title_timer)
+    g_source_remove(win->title_timer);
   taskbar_destroy_item (win);
   switcher_window_delete(win);
   g_free(win->appid);
   g_free(win->title);
+  g_free(win->title_pending);
   g_free(win->output);
   wintree_free_workspace(win->workspace);
-  wt_list = g_list_delete_link(wt_list,item);
+  wintree_index_remove(win);
+  wt_list = g_list_remove(wt_list,win);
   g_free(win);
 }
 
@@ -258,18 +340,19 @@ void wintree_placer_conf( gint xs, gint ys, gint xo, gint yo, gboolean pid )
   placer = TRUE;
 }
 
+gboolean wintree_placer_enabled ( void )
+{
+  return placer;
+}
+
 gboolean wintree_placer_check ( gint pid )
 {
-  GList *iter;
-  gint count = 0;
+  gint64 key = pid;
 
   if(!placer)
     return FALSE;
-  for(iter = wt_list; iter; iter = g_list_next(iter) )
-    if ( ((window_t *)(iter->data))->pid == pid )
-      count++;
 
-  return (count<2);
+  return (!wt_pid || g_list_length(g_hash_table_lookup(wt_pid,&key))<2);
 }
 
 static int comp_int ( const void *x1, const void *x2)
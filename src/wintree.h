@@ -12,6 +12,9 @@ typedef struct wt_window {
   gpointer uid;
   guint16 state;
   gboolean valid;
+  gchar *title_pending;
+  gint64 title_time;
+  guint title_timer;
 } window_t;
 
 struct wintree_api {
@@ -27,14 +30,17 @@ struct wintree_api {
 void wintree_api_register ( struct wintree_api *new );
 window_t *wintree_window_init ( void );
 window_t *wintree_from_id ( gpointer id );
-window_t *wintree_from_pid ( gint64 pid );
 void wintree_window_append ( window_t *win );
 void wintree_window_delete ( gpointer id );
 void wintree_commit ( window_t *win );
+void wintree_set_pid ( window_t *win, gint64 pid );
 void wintree_log ( gpointer id );
 void wintree_set_focus ( gpointer id );
 void wintree_set_active ( gchar *title );
 void wintree_set_title ( gpointer wid, const gchar *title );
+gboolean wintree_update_title ( window_t *win, const gchar *title );
+gboolean wintree_update_app_id ( window_t *win, const gchar *app_id );
+void wintree_set_title_interval ( gint interval );
 void wintree_set_app_id ( gpointer wid, const gchar *app_id);
 void wintree_focus ( gpointer id );
 void wintree_close ( gpointer id );
@@ -50,6 +56,7 @@ gint wintree_compare ( window_t *a, window_t *b);
 void wintree_appid_map_add ( gchar *pattern, gchar *appid );
 gchar *wintree_appid_map_lookup ( gchar *title );
 void wintree_placer_conf( gint xs, gint ys, gint xo, gint yo, gboolean pid );
+gboolean wintree_placer_enabled ( void );
 gboolean wintree_placer_check ( gint pid );
 void wintree_placer_calc ( gint nobs, GdkRectangle *obs, GdkRectangle output,
     GdkRectangle *win );
@@ -0,0 +1,193 @@
+/* This entire file is licensed under GNU General Public License v3.0
+ *
+ * Copyright 2022 sfwbar maintainers
+ */
+
+/* Flow grid microbenchmark.
+ *
+ * A flow grid is filled with a few hundred minimal items, then the cost of
+ * the operations taskbars and pagers perform per event is measured:
+ * adding an item, looking an item up by its parent, retitling an item
+ * (with a re-sort) and deleting an item. Needs a display, exits with 77
+ * (skipped) if gtk can't be initialized.
+ *
+ * Example:
+ *   sfwbar-flowgrid-bench -c 500 -n 5000
+ */
+
+#include <glib.h>
+#include <gtk/gtk.h>
+#include "sfwbar.h"
+#include "flowgrid.h"
+#include "flowitem.h"
+
+/* symbols provided by sfwbar.c in the main binary */
+gchar *confname;
+gchar *sockname;
+static enum ipc_type ipc;
+
+void ipc_set ( enum ipc_type new )
+{
+  ipc = new;
+}
+
+enum ipc_type ipc_get ( void )
+{
+  return ipc;
+}
+
+static gint opt_children = 500;
+static gint opt_iter = 5000;
+
+static GOptionEntry bench_options[] = {
+  { "children", 'c', 0, G_OPTION_ARG_INT, &opt_children,
+    "Number of items in the grid (default 500)", "N" },
+  { "iterations", 'n', 0, G_OPTION_ARG_INT, &opt_iter,
+    "Number of lookups and retitles (default 5000)", "N" },
+  { NULL }
+};
+
+typedef struct {
+  FlowItem parent_instance;
+  gpointer id;
+  gchar *title;
+  GtkWidget *label;
+} BenchItem;
+
+typedef struct {
+  FlowItemClass parent_class;
+} BenchItemClass;
+
+G_DEFINE_TYPE (BenchItem, bench_item, FLOW_ITEM_TYPE);
+
+#define BENCH_ITEM(x) G_TYPE_CHECK_INSTANCE_CAST((x),bench_item_get_type(), \
+    BenchItem)
+
+static void bench_item_update ( GtkWidget *self )
+{
+  BenchItem *item = BENCH_ITEM(self);
+
+  if(g_strcmp0(gtk_label_get_text(GTK_LABEL(item->label)),item->title))
+    gtk_label_set_text(GTK_LABEL(item->label),item->title);
+}
+
+static void *bench_item_get_parent ( GtkWidget *self )
+{
+  return BENCH_ITEM(self)->id;
+}
+
+static gint bench_item_compare ( GtkWidget *a, GtkWidget *b, GtkWidget *p )
+{
+  return g_strcmp0(BENCH_ITEM(a)->title,BENCH_ITEM(b)->title);
+}
+
+static void bench_item_destroy ( GtkWidget *self )
+{
+  g_clear_pointer(&(BENCH_ITEM(self)->title),g_free);
+  GTK_WIDGET_CLASS(bench_item_parent_class)->destroy(self);
+}
+
+static void bench_item_class_init ( BenchItemClass *kclass )
+{
+  GTK_WIDGET_CLASS(kclass)->destroy = bench_item_destroy;
+  FLOW_ITEM_CLASS(kclass)->update = bench_item_update;
+  FLOW_ITEM_CLASS(kclass)->get_parent = bench_item_get_parent;
+  FLOW_ITEM_CLASS(kclass)->compare = bench_item_compare;
+}
+
+static void bench_item_init ( BenchItem *self )
+{
+}
+
+static GtkWidget *bench_item_new ( GtkWidget *grid, gint id )
+{
+  BenchItem *item;
+
+  item = g_object_new(bench_item_get_type(),NULL);
+  item->id = GINT_TO_POINTER(id);
+  item->title = g_strdup_printf("window %08x",g_random_int());
+  item->label = gtk_label_new(NULL);
+  gtk_container_add(GTK_CONTAINER(item),item->label);
+  g_object_ref(G_OBJECT(item));
+  flow_grid_add_child(grid,GTK_WIDGET(item));
+
+  return GTK_WIDGET(item);
+}
+
+static void bench_report ( const gchar *what, gint64 start, gint n )
+{
+  g_print("%-8s %8.2fus per op (%d ops)\n",what,
+      (gdouble)(g_get_monotonic_time()-start)/n,n);
+}
+
+int main ( int argc, char **argv )
+{
+  GOptionContext *context;
+  GError *err = NULL;
+  GtkWidget *grid, **items;
+  BenchItem *item;
+  gint64 start;
+  gint i;
+
+  context = g_option_context_new(NULL);
+  g_option_context_set_summary(context,"Flow grid microbenchmark");
+  g_option_context_add_main_entries(context,bench_options,NULL);
+  if(!g_option_context_parse(context,&argc,&argv,&err) ||
+      opt_children<1 || opt_iter<1)
+  {
+    g_printerr("%s\n",err?err->message:
+        g_option_context_get_help(context,TRUE,NULL));
+    return 1;
+  }
+  g_option_context_free(context);
+
+  if(!gtk_init_check(&argc,&argv))
+  {
+    g_printerr("no display available, skipping\n");
+    return 77;
+  }
+
+  grid = flow_grid_new(FALSE);
+  flow_grid_set_rows(grid,1);
+  g_object_ref_sink(grid);
+  items = g_malloc(sizeof(GtkWidget *)*opt_children);
+
+  g_print("%d children\n",opt_children);
+  start = g_get_monotonic_time();
+  for(i=0;i<opt_children;i++)
+  {
+    items[i] = bench_item_new(grid,i+1);
+    flow_grid_update(grid);
+  }
+  bench_report("add",start,opt_children);
+
+  start = g_get_monotonic_time();
+  for(i=0;i<opt_iter;i++)
+    flow_grid_find_child(grid,GINT_TO_POINTER(g_random_int_range(1,
+            opt_children+1)));
+  bench_report("lookup",start,opt_iter);
+
+  start = g_get_monotonic_time();
+  for(i=0;i<opt_iter;i++)
+  {
+    item = BENCH_ITEM(items[g_random_int_range(0,opt_children)]);
+    g_free(item->title);
+    item->title = g_strdup_printf("window %08x",g_random_int());
+    flow_grid_invalidate_item(grid,GTK_WIDGET(item));
+    flow_grid_update(grid);
+  }
+  bench_report("retitle",start,opt_iter);
+
+  start = g_get_monotonic_time();
+  for(i=0;i<opt_children;i++)
+  {
+    flow_grid_delete_child(grid,GINT_TO_POINTER(i+1));
+    flow_grid_update(grid);
+  }
+  bench_report("delete",start,opt_children);
+
+  g_free(items);
+  gtk_widget_destroy(grid);
+  g_object_unref(grid);
+  return 0;
+}
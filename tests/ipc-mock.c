@@ -0,0 +1,609 @@
+/* This entire file is licensed under GNU General Public License v3.0
+ *
+ * Copyright 2022 sfwbar maintainers
+ */
+
+/* A stand-in for the sway and hyprland IPC servers, used to benchmark
+ * sfwbar's IPC paths without a live compositor session.
+ *
+ * The mock serves canned replies to requests and replays a recorded event
+ * stream at a fixed rate. If a command is given, it is started with the
+ * environment pointing to the mock sockets and with SFWBAR_UPDATE_TRACE
+ * set. sfwbar logs the time of each taskbar/pager update into the trace
+ * file, which is used to report event to widget update latency. CPU time
+ * per event is taken from /proc/<pid>/stat of the command.
+ *
+ * Recordings are text files with one entry per line:
+ *   # comment
+ *   reply <request> <payload>   canned reply to a request. For sway the
+ *                               request is the message type (i.e. 4 for
+ *                               GET_TREE), for hyprland it's the command
+ *                               (i.e. j/clients)
+ *   event <payload>             an event. For sway the payload starts with
+ *                               the event type (i.e. 0x80000003 {...})
+ * The string %SEQ% in an event payload is replaced by a sequence number.
+ *
+ * Example:
+ *   sfwbar-ipc-mock --sway -r 2000 -n 20000 tests/sway-windows.replay \
+ *     -- sfwbar -f sfwbar.config
+ */
+
+#include <glib.h>
+#include <glib-unix.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define MOCK_HEADER_SIZE 14
+
+static const gchar magic[6] = {0x69, 0x33, 0x2d, 0x69, 0x70, 0x63};
+
+static gboolean opt_hypr;
+static gboolean opt_sway;
+static gint opt_rate = 100;
+static gint opt_count;
+static gint opt_warmup = 1000;
+static gint opt_settle = 500;
+static gchar *opt_dir;
+
+static GOptionEntry mock_options[] = {
+  { "sway", 0, 0, G_OPTION_ARG_NONE, &opt_sway, "Emulate sway IPC", NULL },
+  { "hypr", 0, 0, G_OPTION_ARG_NONE, &opt_hypr, "Emulate hyprland IPC",
+    NULL },
+  { "rate", 'r', 0, G_OPTION_ARG_INT, &opt_rate,
+    "Events per second (default 100)", "N" },
+  { "count", 'n', 0, G_OPTION_ARG_INT, &opt_count,
+    "Number of events to send, the recording is looped (default: one pass)",
+    "N" },
+  { "warmup", 'w', 0, G_OPTION_ARG_INT, &opt_warmup,
+    "Delay in ms between client connection and first event (default 1000)",
+    "MS" },
+  { "settle", 's', 0, G_OPTION_ARG_INT, &opt_settle,
+    "Delay in ms after the last event before reporting (default 500)", "MS" },
+  { "dir", 'd', 0, G_OPTION_ARG_FILENAME, &opt_dir,
+    "Directory for sockets and trace (default: a temporary directory)",
+    "DIR" },
+  { NULL }
+};
+
+struct mock_event {
+  guint32 type;
+  gchar *payload;
+};
+
+static GHashTable *replies;
+static GPtrArray *events;
+static GList *listeners;
+static GMainLoop *loop;
+static gchar *trace_file;
+static gint64 *sent;
+static gint64 start_time;
+static guint nsent, ntotal;
+static GPid child_pid;
+static guint64 cpu_start, cpu_end;
+
+static gboolean mock_write_all ( gint fd, const gchar *buf, gsize len )
+{
+  gssize res;
+
+  while(len>0)
+  {
+    res = send(fd,buf,len,MSG_NOSIGNAL);
+    if(res<=0)
+      return FALSE;
+    buf += res;
+    len -= res;
+  }
+  return TRUE;
+}
+
+static gboolean mock_read_all ( gint fd, gchar *buf, gsize len )
+{
+  gssize res;
+
+  while(len>0)
+  {
+    res = recv(fd,buf,len,0);
+    if(res<=0)
+      return FALSE;
+    buf += res;
+    len -= res;
+  }
+  return TRUE;
+}
+
+static gint mock_listen ( const gchar *path )
+{
+  struct sockaddr_un addr;
+  gint sock;
+
+  sock = socket(AF_UNIX,SOCK_STREAM,0);
+  if(sock==-1)
+    return -1;
+  memset(&addr,0,sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path,path,sizeof(addr.sun_path)-1);
+  g_unlink(path);
+  if(bind(sock,(struct sockaddr *)&addr,sizeof(addr))==-1 ||
+      listen(sock,16)==-1)
+  {
+    close(sock);
+    return -1;
+  }
+  return sock;
+}
+
+static guint64 mock_cpu_ticks ( void )
+{
+  gchar *path, *stat, *ptr;
+  guint64 utime = 0, stime = 0;
+
+  if(!child_pid)
+    return 0;
+
+  path = g_strdup_printf("/proc/%d/stat",child_pid);
+  if(g_file_get_contents(path,&stat,NULL,NULL))
+  {
+    /* fields 14 and 15 (utime, stime), counted after the command name */
+    ptr = strrchr(stat,')');
+    if(ptr && sscanf(ptr+2,"%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u "
+          "%" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT,&utime,&stime)!=2)
+      utime = stime = 0;
+    g_free(stat);
+  }
+  g_free(path);
+
+  return utime + stime;
+}
+
+static gint mock_cmp_int64 ( gconstpointer a, gconstpointer b )
+{
+  gint64 x = *(gint64 *)a, y = *(gint64 *)b;
+
+  return x<y ? -1 : x>y;
+}
+
+/* match each event with the first widget update logged after it was sent */
+static void mock_report ( void )
+{
+  GArray *updates, *lat;
+  gchar *trace, **lines;
+  gint64 t;
+  guint i, j, missed = 0;
+
+  g_print("events sent: %u in %.3fs\n",nsent,
+      (gdouble)(g_get_monotonic_time()-start_time)/G_USEC_PER_SEC -
+      (gdouble)opt_settle/1000);
+
+  if(child_pid && nsent)
+    g_print("cpu per event: %.1fus\n",(gdouble)(cpu_end-cpu_start) *
+        G_USEC_PER_SEC / sysconf(_SC_CLK_TCK) / nsent);
+
+  if(!trace_file || !g_file_get_contents(trace_file,&trace,NULL,NULL))
+  {
+    g_print("no update trace available\n");
+    return;
+  }
+
+  updates = g_array_new(FALSE,FALSE,sizeof(gint64));
+  lines = g_strsplit(trace,"\n",-1);
+  for(i=0;lines[i];i++)
+    if(*lines[i])
+    {
+      t = g_ascii_strtoll(lines[i],NULL,10);
+      g_array_append_val(updates,t);
+    }
+  g_strfreev(lines);
+  g_free(trace);
+  g_array_sort(updates,mock_cmp_int64);
+
+  lat = g_array_new(FALSE,FALSE,sizeof(gint64));
+  for(i=0,j=0;i<nsent;i++)
+  {
+    while(j<updates->len && g_array_index(updates,gint64,j)<sent[i])
+      j++;
+    if(j>=updates->len)
+    {
+      missed++;
+      continue;
+    }
+    t = g_array_index(updates,gint64,j) - sent[i];
+    g_array_append_val(lat,t);
+  }
+
+  if(lat->len)
+  {
+    g_array_sort(lat,mock_cmp_int64);
+    g_print("update latency (us): min %" G_GINT64_FORMAT
+        " median %" G_GINT64_FORMAT " p95 %" G_GINT64_FORMAT
+        " max %" G_GINT64_FORMAT "\n",
+        g_array_index(lat,gint64,0),
+        g_array_index(lat,gint64,lat->len/2),
+        g_array_index(lat,gint64,lat->len*95/100),
+        g_array_index(lat,gint64,lat->len-1));
+  }
+  g_print("widget updates: %u, events without an update: %u\n",
+      updates->len,missed);
+
+  g_array_free(lat,TRUE);
+  g_array_free(updates,TRUE);
+}
+
+static gboolean mock_settled ( gpointer data )
+{
+  cpu_end = mock_cpu_ticks();
+  mock_report();
+  g_main_loop_quit(loop);
+  return FALSE;
+}
+
+static void mock_send_event ( struct mock_event *ev )
+{
+  GString *str;
+  GList *iter, *next;
+  gchar *seq, **parts;
+  guint32 len;
+  gint i;
+
+  seq = g_strdup_printf("%u",nsent);
+  parts = g_strsplit(ev->payload,"%SEQ%",-1);
+  str = g_string_new(NULL);
+  if(opt_sway)
+  {
+    g_string_append_len(str,magic,sizeof(magic));
+    g_string_set_size(str,MOCK_HEADER_SIZE);
+  }
+  g_string_append(str,parts[0]);
+  for(i=1;parts[i];i++)
+  {
+    g_string_append(str,seq);
+    g_string_append(str,parts[i]);
+  }
+  g_strfreev(parts);
+  g_free(seq);
+
+  if(opt_sway)
+  {
+    len = str->len - MOCK_HEADER_SIZE;
+    memcpy(str->str+sizeof(magic),&len,sizeof(len));
+    memcpy(str->str+sizeof(magic)+sizeof(len),&ev->type,sizeof(ev->type));
+  }
+  else
+    g_string_append_c(str,'\n');
+
+  sent[nsent++] = g_get_monotonic_time();
+  for(iter=listeners;iter;iter=next)
+  {
+    next = g_list_next(iter);
+    if(!mock_write_all(GPOINTER_TO_INT(iter->data),str->str,str->len))
+    {
+      close(GPOINTER_TO_INT(iter->data));
+      listeners = g_list_delete_link(listeners,iter);
+    }
+  }
+  g_string_free(str,TRUE);
+}
+
+/* events are sent in bursts every millisecond to sustain rates above the
+ * timer resolution */
+static gboolean mock_replay ( gpointer data )
+{
+  guint due;
+
+  due = MIN((g_get_monotonic_time()-start_time) * opt_rate / G_USEC_PER_SEC,
+      ntotal);
+  while(nsent<due)
+    mock_send_event(g_ptr_array_index(events,nsent % events->len));
+
+  if(nsent<ntotal)
+    return TRUE;
+
+  g_timeout_add(opt_settle,mock_settled,NULL);
+  return FALSE;
+}
+
+static gboolean mock_replay_start ( gpointer data )
+{
+  g_print("replaying %u events at %d/s\n",ntotal,opt_rate);
+  cpu_start = mock_cpu_ticks();
+  start_time = g_get_monotonic_time();
+  g_timeout_add(1,mock_replay,NULL);
+  return FALSE;
+}
+
+static void mock_listener_add ( gint fd )
+{
+  static gboolean started;
+
+  listeners = g_list_append(listeners,GINT_TO_POINTER(fd));
+  if(started || !ntotal)
+    return;
+  started = TRUE;
+  g_timeout_add(opt_warmup,mock_replay_start,NULL);
+}
+
+static const gchar *mock_reply_get ( const gchar *request, const gchar *def )
+{
+  const gchar *reply;
+
+  reply = g_hash_table_lookup(replies,request);
+  return reply?reply:def;
+}
+
+/* sway: i3-ipc framing, replies carry the type of the request */
+static gboolean mock_sway_client ( gint fd, GIOCondition cond, gpointer d )
+{
+  gchar header[MOCK_HEADER_SIZE], *payload, *key, *buf;
+  const gchar *reply;
+  guint32 len, type;
+
+  if(!mock_read_all(fd,header,sizeof(header)))
+  {
+    listeners = g_list_remove(listeners,GINT_TO_POINTER(fd));
+    close(fd);
+    return FALSE;
+  }
+  memcpy(&len,header+sizeof(magic),sizeof(len));
+  memcpy(&type,header+sizeof(magic)+sizeof(len),sizeof(type));
+  payload = g_malloc0(len+1);
+  if(len && !mock_read_all(fd,payload,len))
+  {
+    g_free(payload);
+    listeners = g_list_remove(listeners,GINT_TO_POINTER(fd));
+    close(fd);
+    return FALSE;
+  }
+
+  key = g_strdup_printf("%u",type);
+  switch(type)
+  {
+    case 0:
+      reply = mock_reply_get(key,"[ { \"success\": true } ]");
+      break;
+    case 1:
+      reply = mock_reply_get(key,"[]");
+      break;
+    case 2:
+      reply = "{ \"success\": true }";
+      break;
+    case 4:
+      reply = mock_reply_get(key,
+          "{ \"id\": 1, \"type\": \"root\", \"nodes\": [], "
+          "\"floating_nodes\": [] }");
+      break;
+    default:
+      reply = mock_reply_get(key,"{}");
+      break;
+  }
+  g_free(key);
+
+  len = strlen(reply);
+  buf = g_malloc(MOCK_HEADER_SIZE+len);
+  memcpy(buf,magic,sizeof(magic));
+  memcpy(buf+sizeof(magic),&len,sizeof(len));
+  memcpy(buf+sizeof(magic)+sizeof(len),&type,sizeof(type));
+  memcpy(buf+MOCK_HEADER_SIZE,reply,len);
+  mock_write_all(fd,buf,MOCK_HEADER_SIZE+len);
+  g_free(buf);
+
+  if(type==2)
+    mock_listener_add(fd);
+  g_free(payload);
+
+  return TRUE;
+}
+
+static gboolean mock_sway_accept ( gint fd, GIOCondition cond, gpointer d )
+{
+  gint client;
+
+  client = accept(fd,NULL,NULL);
+  if(client!=-1)
+    g_unix_fd_add(client,G_IO_IN | G_IO_HUP | G_IO_ERR,mock_sway_client,NULL);
+  return TRUE;
+}
+
+/* hyprland: one request per connection, the reply is terminated by
+ * closing the connection */
+static gboolean mock_hypr_request ( gint fd, GIOCondition cond, gpointer d )
+{
+  gchar buf[1024];
+  const gchar *reply;
+  gssize len;
+  gint client;
+
+  client = accept(fd,NULL,NULL);
+  if(client==-1)
+    return TRUE;
+
+  len = recv(client,buf,sizeof(buf)-1,0);
+  if(len>0)
+  {
+    buf[len] = '\0';
+    if(!strcmp(buf,"j/clients") || !strcmp(buf,"j/workspaces") ||
+        !strcmp(buf,"j/monitors"))
+      reply = mock_reply_get(buf,"[]");
+    else if(!strcmp(buf,"j/activewindow"))
+      reply = mock_reply_get(buf,"{}");
+    else
+      reply = mock_reply_get(buf,"ok");
+    mock_write_all(client,reply,strlen(reply));
+  }
+  close(client);
+  return TRUE;
+}
+
+static gboolean mock_hypr_accept ( gint fd, GIOCondition cond, gpointer d )
+{
+  gint client;
+
+  client = accept(fd,NULL,NULL);
+  if(client!=-1)
+    mock_listener_add(client);
+  return TRUE;
+}
+
+static gboolean mock_load ( const gchar *fname )
+{
+  struct mock_event *ev;
+  gchar *data, **lines, *ptr, *end;
+  guint i;
+
+  if(!g_file_get_contents(fname,&data,NULL,NULL))
+    return FALSE;
+
+  lines = g_strsplit(data,"\n",-1);
+  for(i=0;lines[i];i++)
+  {
+    ptr = g_strstrip(lines[i]);
+    if(g_str_has_prefix(ptr,"reply "))
+    {
+      ptr += 6;
+      end = strchr(ptr,' ');
+      if(end)
+        g_hash_table_insert(replies,g_strndup(ptr,end-ptr),
+            g_strdup(end+1));
+    }
+    else if(g_str_has_prefix(ptr,"event "))
+    {
+      ev = g_malloc0(sizeof(struct mock_event));
+      ptr += 6;
+      if(opt_sway)
+      {
+        ev->type = strtoul(ptr,&end,0);
+        ptr = end;
+        while(*ptr==' ')
+          ptr++;
+      }
+      ev->payload = g_strdup(ptr);
+      g_ptr_array_add(events,ev);
+    }
+  }
+  g_strfreev(lines);
+  g_free(data);
+
+  return TRUE;
+}
+
+static void mock_child_exit ( GPid pid, gint status, gpointer data )
+{
+  g_spawn_close_pid(pid);
+  if(!cpu_end)
+  {
+    g_printerr("command exited before the replay completed\n");
+    child_pid = 0;
+    mock_report();
+  }
+  g_main_loop_quit(loop);
+}
+
+int main ( int argc, char **argv )
+{
+  GOptionContext *context;
+  GError *err = NULL;
+  gchar **envp, *path, *dir, **cmd = NULL;
+  gint sock, i;
+
+  for(i=1;i<argc;i++)
+    if(!strcmp(argv[i],"--"))
+    {
+      cmd = argv+i+1;
+      argv[i] = NULL;
+      argc = i;
+      break;
+    }
+
+  context = g_option_context_new("RECORDING [-- COMMAND ...]");
+  g_option_context_set_summary(context,
+      "Compositor IPC stand-in for sfwbar benchmarks");
+  g_option_context_add_main_entries(context,mock_options,NULL);
+  if(!g_option_context_parse(context,&argc,&argv,&err) || argc!=2 ||
+      opt_sway==opt_hypr || opt_rate<1)
+  {
+    g_printerr("%s",err?err->message:
+        g_option_context_get_help(context,TRUE,NULL));
+    return 1;
+  }
+  g_option_context_free(context);
+
+  replies = g_hash_table_new_full(g_str_hash,g_str_equal,g_free,g_free);
+  events = g_ptr_array_new();
+  if(!mock_load(argv[1]))
+  {
+    g_printerr("unable to read %s\n",argv[1]);
+    return 1;
+  }
+  if(events->len)
+    ntotal = opt_count>0 ? opt_count : events->len;
+  sent = g_malloc0(sizeof(gint64)*(ntotal+1));
+
+  dir = opt_dir?g_strdup(opt_dir):g_dir_make_tmp("sfwbar-mock-XXXXXX",NULL);
+  if(!dir)
+    return 1;
+  envp = g_get_environ();
+
+  if(opt_sway)
+  {
+    path = g_build_filename(dir,"sway-ipc.sock",NULL);
+    sock = mock_listen(path);
+    if(sock!=-1)
+      g_unix_fd_add(sock,G_IO_IN,mock_sway_accept,NULL);
+    envp = g_environ_setenv(envp,"SWAYSOCK",path,TRUE);
+    envp = g_environ_unsetenv(envp,"HYPRLAND_INSTANCE_SIGNATURE");
+  }
+  else
+  {
+    path = g_build_filename(dir,"hypr","mock",NULL);
+    g_mkdir_with_parents(path,0700);
+    g_free(path);
+    path = g_build_filename(dir,"hypr","mock",".socket.sock",NULL);
+    sock = mock_listen(path);
+    if(sock!=-1)
+      g_unix_fd_add(sock,G_IO_IN,mock_hypr_request,NULL);
+    g_free(path);
+    path = g_build_filename(dir,"hypr","mock",".socket2.sock",NULL);
+    if(sock!=-1)
+      sock = mock_listen(path);
+    if(sock!=-1)
+      g_unix_fd_add(sock,G_IO_IN,mock_hypr_accept,NULL);
+    envp = g_environ_setenv(envp,"XDG_RUNTIME_DIR",dir,TRUE);
+    envp = g_environ_setenv(envp,"HYPRLAND_INSTANCE_SIGNATURE","mock",TRUE);
+    envp = g_environ_unsetenv(envp,"SWAYSOCK");
+  }
+  if(sock==-1)
+  {
+    g_printerr("unable to listen on %s\n",path);
+    return 1;
+  }
+  g_print("listening on %s\n",path);
+  g_free(path);
+
+  loop = g_main_loop_new(NULL,FALSE);
+
+  if(cmd && *cmd)
+  {
+    trace_file = g_build_filename(dir,"update-trace",NULL);
+    g_unlink(trace_file);
+    envp = g_environ_setenv(envp,"SFWBAR_UPDATE_TRACE",trace_file,TRUE);
+    if(!g_spawn_async(NULL,cmd,envp,G_SPAWN_SEARCH_PATH |
+          G_SPAWN_DO_NOT_REAP_CHILD,NULL,NULL,&child_pid,&err))
+    {
+      g_printerr("%s\n",err->message);
+      return 1;
+    }
+    g_child_watch_add(child_pid,mock_child_exit,NULL);
+  }
+
+  g_main_loop_run(loop);
+
+  if(child_pid)
+    kill(child_pid,SIGTERM);
+  g_strfreev(envp);
+  g_free(dir);
+  return 0;
+}
@@ -0,0 +1,152 @@
+/* This entire file is licensed under GNU General Public License v3.0
+ *
+ * Copyright 2022 sfwbar maintainers
+ */
+
+/* Compare jscan against a full json-c parse on IPC payloads.
+ *
+ * Both readers extract the same dotted keys from a payload (by default the
+ * fields sfwbar reads from sway window events) and the time per payload
+ * is reported. Values extracted by both readers are compared on the first
+ * pass.
+ *
+ * Example:
+ *   sfwbar-jscan-bench tests/sway-window-event.json
+ *   sfwbar-jscan-bench tests/sway-tree.json id name rect.width
+ */
+
+#include <glib.h>
+#include <json.h>
+#include <string.h>
+#include "sfwbar.h"
+
+static gint opt_iter = 10000;
+
+static GOptionEntry bench_options[] = {
+  { "iterations", 'n', 0, G_OPTION_ARG_INT, &opt_iter,
+    "Number of parses per reader (default 10000)", "N" },
+  { NULL }
+};
+
+static const gchar *window_keys[] = { "change", "container.id",
+  "container.pid", "container.name", "container.app_id",
+  "container.window_properties.instance", "container.focused",
+  "container.fullscreen_mode", NULL };
+
+static const gchar *bench_json_get ( struct json_object *obj,
+    const gchar *key )
+{
+  gchar **path;
+  gint i;
+
+  path = g_strsplit(key,".",-1);
+  for(i=0;path[i] && obj;i++)
+    if(!json_object_object_get_ex(obj,path[i],&obj))
+      obj = NULL;
+  g_strfreev(path);
+
+  if(!obj || json_object_is_type(obj,json_type_object) ||
+      json_object_is_type(obj,json_type_array))
+    return NULL;
+  return json_object_get_string(obj);
+}
+
+static guint bench_check ( const gchar *data, const gchar **keys )
+{
+  struct json_object *obj;
+  JScan *scan;
+  guint i, errors = 0;
+
+  scan = jscan_parse(data,keys);
+  obj = json_tokener_parse(data);
+  for(i=0;keys[i];i++)
+    if(g_strcmp0(jscan_get_string(scan,keys[i]),bench_json_get(obj,keys[i])))
+    {
+      g_printerr("mismatch on %s: jscan '%s', json-c '%s'\n",keys[i],
+          jscan_get_string(scan,keys[i]),bench_json_get(obj,keys[i]));
+      errors++;
+    }
+  json_object_put(obj);
+  jscan_free(scan);
+
+  return errors;
+}
+
+static gdouble bench_jscan ( const gchar *data, const gchar **keys )
+{
+  JScan *scan;
+  gint64 start;
+  gint n, i;
+
+  start = g_get_monotonic_time();
+  for(n=0;n<opt_iter;n++)
+  {
+    scan = jscan_parse(data,keys);
+    for(i=0;keys[i];i++)
+      jscan_get_string(scan,keys[i]);
+    jscan_free(scan);
+  }
+  return (gdouble)(g_get_monotonic_time()-start)/opt_iter;
+}
+
+static gdouble bench_json_c ( const gchar *data, const gchar **keys )
+{
+  struct json_object *obj;
+  gint64 start;
+  gint n, i;
+
+  start = g_get_monotonic_time();
+  for(n=0;n<opt_iter;n++)
+  {
+    obj = json_tokener_parse(data);
+    for(i=0;keys[i];i++)
+      bench_json_get(obj,keys[i]);
+    json_object_put(obj);
+  }
+  return (gdouble)(g_get_monotonic_time()-start)/opt_iter;
+}
+
+int main ( int argc, char **argv )
+{
+  GOptionContext *context;
+  GError *err = NULL;
+  const gchar **keys;
+  gchar *data;
+  gsize len;
+  gdouble tj, tc;
+  guint errors;
+
+  context = g_option_context_new("PAYLOAD [KEY ...]");
+  g_option_context_set_summary(context,
+      "Benchmark jscan against json-c on an IPC payload");
+  g_option_context_add_main_entries(context,bench_options,NULL);
+  if(!g_option_context_parse(context,&argc,&argv,&err) || argc<2 ||
+      opt_iter<1)
+  {
+    g_printerr("%s\n",err?err->message:
+        g_option_context_get_help(context,TRUE,NULL));
+    return 1;
+  }
+  g_option_context_free(context);
+
+  if(!g_file_get_contents(argv[1],&data,&len,&err))
+  {
+    g_printerr("%s\n",err->message);
+    return 1;
+  }
+  keys = argc>2 ? (const gchar **)argv+2 : window_keys;
+
+  errors = bench_check(data,keys);
+  tj = bench_jscan(data,keys);
+  tc = bench_json_c(data,keys);
+
+  g_print("payload: %s (%" G_GSIZE_FORMAT " bytes), %d iterations\n",
+      argv[1],len,opt_iter);
+  g_print("jscan:  %.2fus per payload\n",tj);
+  g_print("json-c: %.2fus per payload\n",tc);
+  if(tj>0)
+    g_print("speedup: %.1fx\n",tc/tj);
+
+  g_free(data);
+  return errors?1:0;
+}
@@ -0,0 +1,296 @@
+/* This entire file is licensed under GNU General Public License v3.0
+ *
+ * Copyright 2022 sfwbar maintainers
+ */
+
+/* StatusNotifierItem property fetch benchmark.
+ *
+ * A private session bus is started (GTestDBus, needs dbus-daemon) and a
+ * thread serves a number of fake SNI items on it. sfwbar's item code then
+ * loads all items and the time until every item has its properties is
+ * reported, along with the number of D-Bus calls the items received.
+ * With --no-getall, the fake items reject Properties.GetAll, which times
+ * the per-property Get fallback. Exits with 77 (skipped) if dbus-daemon
+ * isn't available.
+ *
+ * Example:
+ *   sfwbar-sni-bench -c 50 -n 20
+ *   sfwbar-sni-bench -c 50 -n 20 --no-getall
+ */
+
+#include <glib.h>
+#include <gio/gio.h>
+#include <gtk/gtk.h>
+#include <string.h>
+#include "sfwbar.h"
+#include "sni.h"
+
+/* symbols provided by sfwbar.c in the main binary */
+gchar *confname;
+gchar *sockname;
+static enum ipc_type ipc;
+
+void ipc_set ( enum ipc_type new )
+{
+  ipc = new;
+}
+
+enum ipc_type ipc_get ( void )
+{
+  return ipc;
+}
+
+static gint opt_items = 50;
+static gint opt_iter = 20;
+static gboolean opt_no_getall;
+
+static GOptionEntry bench_options[] = {
+  { "items", 'c', 0, G_OPTION_ARG_INT, &opt_items,
+    "Number of fake items (default 50)", "N" },
+  { "iterations", 'n', 0, G_OPTION_ARG_INT, &opt_iter,
+    "Number of times all items are loaded (default 20)", "N" },
+  { "no-getall", 0, 0, G_OPTION_ARG_NONE, &opt_no_getall,
+    "Reject GetAll calls, forcing one Get call per property", NULL },
+  { NULL }
+};
+
+static const gchar bench_item_xml[] =
+  "<node>"
+  " <interface name='org.kde.StatusNotifierItem'>"
+  "  <property type='s' name='Category' access='read'/>"
+  "  <property type='s' name='Id' access='read'/>"
+  "  <property type='s' name='Title' access='read'/>"
+  "  <property type='s' name='Status' access='read'/>"
+  "  <property type='s' name='IconName' access='read'/>"
+  "  <property type='s' name='OverlayIconName' access='read'/>"
+  "  <property type='s' name='AttentionIconName' access='read'/>"
+  "  <property type='s' name='AttentionMovieName' access='read'/>"
+  "  <property type='s' name='XAyatanaLabel' access='read'/>"
+  "  <property type='s' name='XAyatanaLabelGuide' access='read'/>"
+  "  <property type='s' name='IconThemePath' access='read'/>"
+  "  <property type='a(iiay)' name='IconPixmap' access='read'/>"
+  "  <property type='a(iiay)' name='OverlayIconPixmap' access='read'/>"
+  "  <property type='a(iiay)' name='AttentionIconPixmap' access='read'/>"
+  "  <property type='i' name='WindowId' access='read'/>"
+  "  <property type='(sa(iiay)ss)' name='ToolTip' access='read'/>"
+  "  <property type='b' name='ItemIsMenu' access='read'/>"
+  "  <property type='o' name='Menu' access='read'/>"
+  "  <property type='u' name='XAyatanaOrderingIndex' access='read'/>"
+  " </interface>"
+  "</node>";
+
+static gint bench_calls;
+
+/* a 16x16 and a 32x32 icon, as most items send */
+static GVariant *bench_pixmap ( void )
+{
+  GVariantBuilder builder;
+  guchar *data;
+  gint size;
+
+  g_variant_builder_init(&builder,G_VARIANT_TYPE("a(iiay)"));
+  for(size=16; size<=32; size*=2)
+  {
+    data = g_malloc(size*size*4);
+    memset(data,0x80,size*size*4);
+    g_variant_builder_add(&builder,"(ii@ay)",size,size,
+        g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE,data,size*size*4,1));
+    g_free(data);
+  }
+  return g_variant_builder_end(&builder);
+}
+
+static GVariant *bench_item_get_prop ( GDBusConnection *con,
+    const gchar *sender, const gchar *path, const gchar *iface,
+    const gchar *prop, GError **err, gpointer data )
+{
+  gint id = GPOINTER_TO_INT(data);
+
+  if(!g_strcmp0(prop,"Category"))
+    return g_variant_new_string("ApplicationStatus");
+  if(!g_strcmp0(prop,"Id"))
+    return g_variant_new_take_string(g_strdup_printf("bench-%d",id));
+  if(!g_strcmp0(prop,"Title"))
+    return g_variant_new_take_string(g_strdup_printf("Bench item %d",id));
+  if(!g_strcmp0(prop,"Status"))
+    return g_variant_new_string("Active");
+  if(!g_strcmp0(prop,"IconPixmap"))
+    return bench_pixmap();
+  if(g_str_has_suffix(prop,"Pixmap"))
+    return g_variant_new_array(G_VARIANT_TYPE("(iiay)"),NULL,0);
+  if(!g_strcmp0(prop,"WindowId"))
+    return g_variant_new_int32(0);
+  if(!g_strcmp0(prop,"ToolTip"))
+    return g_variant_new("(s@a(iiay)ss)","",
+        g_variant_new_array(G_VARIANT_TYPE("(iiay)"),NULL,0),
+        "Bench item","");
+  if(!g_strcmp0(prop,"ItemIsMenu"))
+    return g_variant_new_boolean(FALSE);
+  if(!g_strcmp0(prop,"Menu"))
+    return g_variant_new_object_path("/MenuBar");
+  if(!g_strcmp0(prop,"XAyatanaOrderingIndex"))
+    return g_variant_new_uint32(id);
+  return g_variant_new_string("");
+}
+
+static const GDBusInterfaceVTable bench_item_vtable = {
+  NULL, bench_item_get_prop, NULL
+};
+
+/* count method calls reaching the items and, with --no-getall, answer
+ * GetAll with an error. Runs in the GDBus worker thread */
+static GDBusMessage *bench_filter ( GDBusConnection *con, GDBusMessage *msg,
+    gboolean incoming, gpointer data )
+{
+  GDBusMessage *reply;
+
+  if(!incoming || g_dbus_message_get_message_type(msg) !=
+      G_DBUS_MESSAGE_TYPE_METHOD_CALL)
+    return msg;
+
+  g_atomic_int_inc(&bench_calls);
+  if(!opt_no_getall || g_strcmp0(g_dbus_message_get_member(msg),"GetAll"))
+    return msg;
+
+  reply = g_dbus_message_new_method_error(msg,
+      "org.freedesktop.DBus.Error.UnknownMethod","GetAll not supported");
+  g_dbus_connection_send_message(con,reply,G_DBUS_SEND_MESSAGE_FLAGS_NONE,
+      NULL,NULL);
+  g_object_unref(reply);
+  g_object_unref(msg);
+  return NULL;
+}
+
+/* serve the fake items from their own connection and main context, so
+ * they answer while the main thread waits on its own loop */
+static gpointer bench_server_thread ( gpointer queue )
+{
+  GMainContext *context;
+  GDBusConnection *con;
+  GDBusNodeInfo *idata;
+  GError *err = NULL;
+  gchar *path;
+  gint i;
+
+  context = g_main_context_new();
+  g_main_context_push_thread_default(context);
+
+  con = g_dbus_connection_new_for_address_sync(
+      g_getenv("DBUS_SESSION_BUS_ADDRESS"),
+      G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+      G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,NULL,NULL,&err);
+  if(!con)
+  {
+    g_printerr("unable to connect to the test bus: %s\n",err->message);
+    g_async_queue_push(queue,g_strdup(""));
+    return NULL;
+  }
+  g_dbus_connection_add_filter(con,bench_filter,NULL,NULL);
+
+  idata = g_dbus_node_info_new_for_xml(bench_item_xml,NULL);
+  for(i=0; i<opt_items; i++)
+  {
+    path = g_strdup_printf("/StatusNotifierItem/%d",i);
+    g_dbus_connection_register_object(con,path,idata->interfaces[0],
+        &bench_item_vtable,GINT_TO_POINTER(i),NULL,NULL);
+    g_free(path);
+  }
+  g_async_queue_push(queue,g_strdup(g_dbus_connection_get_unique_name(con)));
+
+  while(TRUE)
+    g_main_context_iteration(context,TRUE);
+
+  return NULL;
+}
+
+static gboolean bench_loaded ( SniItem **items )
+{
+  gint i;
+
+  for(i=0; i<opt_items; i++)
+    if(items[i]->ref || !items[i]->string[SNI_PROP_TITLE] ||
+        !items[i]->pixmap[0])
+      return FALSE;
+  return TRUE;
+}
+
+int main ( int argc, char **argv )
+{
+  GOptionContext *context;
+  GError *err = NULL;
+  GTestDBus *bus;
+  GAsyncQueue *queue;
+  GDBusConnection *con;
+  SniHost host = { .item_iface = (gchar *)"org.kde.StatusNotifierItem" };
+  SniItem **items;
+  gchar *dest, *uid;
+  gint64 start, total = 0;
+  gint i, n, calls = 0;
+
+  context = g_option_context_new(NULL);
+  g_option_context_set_summary(context,
+      "Benchmark loading StatusNotifierItem properties");
+  g_option_context_add_main_entries(context,bench_options,NULL);
+  if(!g_option_context_parse(context,&argc,&argv,&err) ||
+      opt_items<1 || opt_iter<1)
+  {
+    g_printerr("%s\n",err?err->message:
+        g_option_context_get_help(context,TRUE,NULL));
+    return 1;
+  }
+  g_option_context_free(context);
+
+  if(!(dest = g_find_program_in_path("dbus-daemon")))
+  {
+    g_printerr("dbus-daemon not found, skipping\n");
+    return 77;
+  }
+  g_free(dest);
+
+  bus = g_test_dbus_new(G_TEST_DBUS_NONE);
+  g_test_dbus_up(bus);
+
+  queue = g_async_queue_new();
+  g_thread_unref(g_thread_new("sni-items",bench_server_thread,queue));
+  dest = g_async_queue_pop(queue);
+  g_async_queue_unref(queue);
+  if(!*dest || !(con = sni_get_connection()))
+  {
+    g_test_dbus_stop(bus);
+    return 1;
+  }
+
+  items = g_malloc(sizeof(SniItem *)*opt_items);
+  for(n=0; n<opt_iter; n++)
+  {
+    g_atomic_int_set(&bench_calls,0);
+    start = g_get_monotonic_time();
+    for(i=0; i<opt_items; i++)
+    {
+      uid = g_strdup_printf("%s/StatusNotifierItem/%d",dest,i);
+      items[i] = sni_item_new(con,&host,uid);
+      g_free(uid);
+    }
+    while(!bench_loaded(items))
+      g_main_context_iteration(NULL,TRUE);
+    total += g_get_monotonic_time() - start;
+    calls = g_atomic_int_get(&bench_calls);
+
+    for(i=0; i<opt_items; i++)
+      sni_item_free(items[i]);
+  }
+
+  g_print("%d items, %d iterations, %s\n",opt_items,opt_iter,
+      opt_no_getall?"per-property Get":"GetAll");
+  g_print("load:  %.2fms for all items, %.2fus per item\n",
+      (gdouble)total/opt_iter/1000,(gdouble)total/opt_iter/opt_items);
+  g_print("calls: %d per load, %.1f per item\n",calls,
+      (gdouble)calls/opt_items);
+
+  g_free(items);
+  g_free(dest);
+  /* sfwbar keeps its bus connection, so don't wait for it to close */
+  g_test_dbus_stop(bus);
+  g_object_unref(bus);
+  return 0;
+}